@@ -0,0 +1,197 @@
+#include "Synthetic.h"
+
+#include <opencv2/videoio.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Blank modules around the QR code, as required by the standard.
+#define QR_QUIET_ZONE 4
+
+SyntheticStereo::SyntheticStereo(SyntheticStereo::Settings settings)
+    : Config{settings}
+{
+    const cv::Size& size = Config.FrameSize;
+    cv::RNG rng(Config.Seed);
+
+    // Murky water, brighter towards the surface, with some low frequency
+    // texture so the background subtractors have something to learn.
+    cv::Mat texture(std::max(size.height / 32, 2), std::max(size.width / 32, 2), CV_8UC3);
+    rng.fill(texture, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(40));
+    cv::resize(texture, _background, size, 0, 0, cv::INTER_CUBIC);
+    for(int y = 0; y < size.height; y++)
+    {
+        cv::Mat row = _background.row(y);
+        row += cv::Scalar(90, 70, 20) * (1.0 - 0.5 * y / size.height);
+    }
+
+    // A distorted pixel shows what the ideal camera sees at its undistorted
+    // position, so that cv::undistort recovers the ideal frame.
+    std::vector<cv::Point2f> pixels, ideal;
+    pixels.reserve(size.area());
+    for(int y = 0; y < size.height; y++)
+        for(int x = 0; x < size.width; x++)
+            pixels.push_back(cv::Point2f((float)x, (float)y));
+    cv::undistortPoints(pixels, ideal, CameraMatrix(), DistCoeffs(), cv::noArray(), CameraMatrix());
+
+    _map_x.create(size, CV_32FC1);
+    _map_y.create(size, CV_32FC1);
+    for(int y = 0; y < size.height; y++)
+        for(int x = 0; x < size.width; x++)
+        {
+            _map_x.at<float>(y, x) = ideal[y * size.width + x].x;
+            _map_y.at<float>(y, x) = ideal[y * size.width + x].y;
+        }
+}
+
+cv::Mat SyntheticStereo::Frame(int camera, int index) const
+{
+    cv::Mat ideal = _background.clone();
+
+    // The right camera runs SyncOffset frames behind the left one.
+    int left_index = camera == 0 ? index : index - Config.SyncOffset;
+    if(left_index >= 0 && left_index < Config.QRFrames)
+        DrawQR(ideal);
+
+    for(auto& fish : Fish(left_index))
+    {
+        cv::Point2f centre = fish.centre - cv::Point2f(camera == 0 ? 0.f : (float)Config.Disparity, 0.f);
+        cv::ellipse(ideal, cv::RotatedRect(centre, fish.axes, fish.angle), cv::Scalar(170, 175, 180), cv::FILLED);
+        cv::ellipse(ideal, cv::RotatedRect(centre, fish.axes * 0.5f, fish.angle), cv::Scalar(120, 125, 130), cv::FILLED);
+    }
+
+    // Sensor noise, different in every frame and camera.
+    cv::RNG rng(Config.Seed + 2 * (unsigned int)std::max(index, 0) + camera + 1);
+    cv::Mat noise(ideal.size(), CV_8UC3);
+    rng.fill(noise, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(4));
+    cv::add(ideal, noise, ideal);
+
+    cv::Mat frame;
+    cv::remap(ideal, frame, _map_x, _map_y, cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+    return frame;
+}
+
+std::pair<std::string, std::string> SyntheticStereo::WriteVideos(const std::string& dir, const std::string& name) const
+{
+    cv::utils::fs::createDirectories(dir);
+    std::string files[2] = { cv::utils::fs::join(dir, name + "_left.mp4"),
+                             cv::utils::fs::join(dir, name + "_right.mp4") };
+
+    for(int camera = 0; camera < 2; camera++)
+    {
+        cv::VideoWriter writer(files[camera], cv::VideoWriter::fourcc('m', 'p', '4', 'v'), Config.FPS,
+                               Config.FrameSize, true);
+        if(!writer.isOpened())
+            throw std::runtime_error("Could not write synthetic video \"" + files[camera] + "\"!");
+
+        int n_frames = Config.Frames + (camera == 0 ? 0 : Config.SyncOffset);
+        for(int i = 0; i < n_frames; i++)
+            writer << Frame(camera, i);
+    }
+
+    return std::make_pair(files[0], files[1]);
+}
+
+std::vector<std::pair<int, int>> SyntheticStereo::Activity() const
+{
+    std::vector<std::pair<int, int>> activity;
+    for(int i = 0; i < Config.Fish; i++)
+    {
+        int start = Config.QRFrames + Config.IdleFrames + i * (Config.FishFrames + Config.IdleFrames);
+        if(start >= Config.Frames) break;
+        activity.push_back(std::make_pair(start, std::min(start + Config.FishFrames, Config.Frames) - 1));
+    }
+    return activity;
+}
+
+std::vector<SyntheticStereo::Blob> SyntheticStereo::Fish(int index) const
+{
+    std::vector<Blob> fish;
+    auto activity = Activity();
+    float width = (float)Config.FrameSize.width, height = (float)Config.FrameSize.height;
+    for(size_t i = 0; i < activity.size(); i++)
+    {
+        if(index < activity[i].first || index > activity[i].second)
+            continue;
+
+        // Every fish has its own size, depth and swimming direction.
+        cv::RNG rng(Config.Seed * 31 + (unsigned int)i);
+        float length = width * rng.uniform(0.06f, 0.12f);
+        float y = height * rng.uniform(0.3f, 0.7f);
+        float t = (float)(index - activity[i].first) / std::max(Config.FishFrames - 1, 1);
+        if(i % 2) t = 1.f - t;
+
+        Blob blob;
+        blob.centre = cv::Point2f(width * (0.2f + 0.6f * t), y + height * 0.03f * std::sin(6.f * t));
+        blob.axes = cv::Size2f(length, length * 0.35f);
+        blob.angle = 10.f * std::cos(6.f * t);
+        fish.push_back(blob);
+    }
+    return fish;
+}
+
+cv::Mat SyntheticStereo::CameraMatrix() const
+{
+    double focal = 0.8 * Config.FrameSize.width;
+    return (cv::Mat_<double>(3, 3) << focal, 0, Config.FrameSize.width / 2.0,
+                                      0, focal, Config.FrameSize.height / 2.0,
+                                      0, 0, 1);
+}
+
+cv::Mat SyntheticStereo::DistCoeffs() const
+{
+    return (cv::Mat_<double>(1, 5) << Config.K1, Config.K2, 0, 0, 0);
+}
+
+const std::vector<std::string>& SyntheticStereo::QRModules()
+{
+    // Version 2-L, mask 0, encoding "geo:49.2827,-123.1207".
+    static const std::vector<std::string> modules = {
+        "#######..#..#..##.#######",
+        "#.....#...####.#..#.....#",
+        "#.###.#.###.#..#..#.###.#",
+        "#.###.#..###......#.###.#",
+        "#.###.#...#....##.#.###.#",
+        "#.....#..#.....##.#.....#",
+        "#######.#.#.#.#.#.#######",
+        "........###.##...........",
+        "###.#####.##.##..##...#..",
+        "...#.#.#..##.##...##..###",
+        "##.##.##.#....#.#.#.##.##",
+        "##.#.......#.#...#####...",
+        "......###...###...##.#.##",
+        "....#...#..####...##.####",
+        "#.##..##.#####...##....##",
+        ".###.#...#..####..##.#..#",
+        "#.#..##.#.##..#.######.##",
+        "........##.#....#...#..##",
+        "#######.###..#.##.#.#.###",
+        "#.....#.##.#...##...##...",
+        "#.###.#.###.#...######.##",
+        "#.###.#..#####...#..###..",
+        "#.###.#.#..##.##....###.#",
+        "#.....#.###.#####.####.#.",
+        "#######.#.##..#.#.##...##"
+    };
+    return modules;
+}
+
+void SyntheticStereo::DrawQR(cv::Mat& frame) const
+{
+    const auto& modules = QRModules();
+    int n_modules = (int)modules.size() + 2 * QR_QUIET_ZONE;
+    int module = std::max(std::min(frame.cols, frame.rows) * 3 / 5 / n_modules, 1);
+
+    cv::Point origin((frame.cols - n_modules * module) / 2, (frame.rows - n_modules * module) / 2);
+    cv::rectangle(frame, cv::Rect(origin.x, origin.y, n_modules * module, n_modules * module),
+                  cv::Scalar::all(255), cv::FILLED);
+
+    origin += cv::Point(QR_QUIET_ZONE * module, QR_QUIET_ZONE * module);
+    for(size_t y = 0; y < modules.size(); y++)
+        for(size_t x = 0; x < modules[y].size(); x++)
+            if(modules[y][x] == '#')
+                cv::rectangle(frame, cv::Rect(origin.x + (int)x * module, origin.y + (int)y * module, module, module),
+                              cv::Scalar::all(0), cv::FILLED);
+}
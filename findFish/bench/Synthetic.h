@@ -0,0 +1,105 @@
+/// \date October 16, 2026
+///
+/// Deterministic synthetic stereo footage for benchmarks and regression
+/// tests. Both cameras look at the same textured, static background through a
+/// known lens distortion. The first frames show a QR code for syncing, after
+/// which elliptical blobs standing in for fish swim through the scene at known
+/// times, shifted between the cameras by a fixed disparity.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Renders synthetic stereo frames and videos with known ground truth.
+class SyntheticStereo
+{
+public:
+    /// Nested wrapper class for settings pertaining to the footage.
+    struct Settings
+    {
+        cv::Size FrameSize = cv::Size(1280, 720);
+        int Frames = 300;
+        int FPS = 30;
+        unsigned int Seed = 42;
+
+        // The QR code is shown for the first QRFrames frames of the left
+        // camera, and SyncOffset frames later in the right camera.
+        int QRFrames = 1;
+        int SyncOffset = 0;
+
+        // Fish swim through the scene one after another, each visible for
+        // FishFrames frames with IdleFrames of empty water in between.
+        int Fish = 4;
+        int FishFrames = 40;
+        int IdleFrames = 30;
+        int Disparity = 40;
+
+        // Radial distortion applied to both cameras.
+        double K1 = -0.15;
+        double K2 = 0.02;
+    };
+
+    /// A fish blob at a single frame.
+    struct Blob
+    {
+        cv::Point2f centre;
+        cv::Size2f axes;
+        float angle;
+    };
+
+public:
+    /// Prepares the scene and the distortion maps.
+    /// \param[in] settings The settings for the footage.
+    SyntheticStereo(Settings settings);
+
+    /// Renders a single frame of a camera.
+    /// \param[in] camera The index of the camera.
+    /// \param[in] index The index of the frame in that camera's video.
+    /// \return The distorted BGR frame.
+    cv::Mat Frame(int camera, int index) const;
+
+    /// Writes both videos, named "<name>_left.mp4" and "<name>_right.mp4" so
+    /// the Processor pairs them.
+    /// \param[in] dir The directory to write to.
+    /// \param[in] name The shared name of the videos.
+    /// \return The paths of the left and right videos.
+    std::pair<std::string, std::string> WriteVideos(const std::string& dir, const std::string& name) const;
+
+    /// Gets the frames of the left camera during which fish are visible.
+    /// \return Inclusive [start, end] ranges of left camera frames.
+    std::vector<std::pair<int, int>> Activity() const;
+
+    /// Gets the fish visible in a frame of the left camera.
+    /// \param[in] index The index of the frame.
+    /// \return The undistorted blobs.
+    std::vector<Blob> Fish(int index) const;
+
+    /// Gets the camera matrix both cameras were rendered with.
+    /// \return The 3x3 camera matrix.
+    cv::Mat CameraMatrix() const;
+
+    /// Gets the distortion both cameras were rendered with.
+    /// \return The distortion coefficients (k1, k2, p1, p2, k3).
+    cv::Mat DistCoeffs() const;
+
+    /// Gets the module matrix of the sync QR code, one string per row with
+    /// '#' for dark modules.
+    /// \return The rows of the QR code.
+    static const std::vector<std::string>& QRModules();
+
+public:
+    /// Settings for the footage.
+    Settings Config;
+
+private:
+    /// Draws the QR code in the middle of a frame.
+    void DrawQR(cv::Mat& frame) const;
+
+private:
+    cv::Mat _background;
+    cv::Mat _map_x, _map_y;
+};
@@ -0,0 +1,193 @@
+/// \date October 16, 2026
+///
+/// Benchmarks the whole processing pipeline on synthetic stereo footage, so it
+/// runs offline and gives the same numbers on every machine. For every
+/// resolution a pair of videos is generated once, and then processed with
+/// every thread count the same way the Processor does: syncing on the QR code,
+/// undistorting, tracking, and encoding the concatenated frames along with
+/// their reviewing proxy.
+///
+/// Usage: bench_findFish [frames] [threads...]
+
+#include "Synthetic.h"
+#include "../resources/includes/Tracker.h"
+#include "../resources/includes/EventDetector.h"
+#include "../resources/includes/Metrics.h"
+#include "../resources/includes/SyncEngine.h"
+#include "../resources/includes/Processor.h"
+
+#include <opencv2/videoio.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define DEFAULT_FRAMES 300
+#define BENCH_DIR "bench_data/"
+#define PROXY_WIDTH 960
+
+int RunPipeline(const SyntheticStereo&, const std::pair<std::string, std::string>&, std::shared_ptr<Metrics>, size_t&);
+double StageMs(const Metrics&, const char*, int);
+
+int main(int argc, char** argv)
+{
+    int n_frames = argc > 1 ? std::atoi(argv[1]) : DEFAULT_FRAMES;
+
+    std::vector<int> threads;
+    for (int i = 2; i < argc; i++)
+        threads.push_back(std::atoi(argv[i]));
+    if (threads.empty())
+        threads = { 1, cv::getNumberOfCPUs() };
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    std::printf("%-10s %7s %8s %8s %10s %10s %10s %10s %10s %6s\n", "size", "threads", "fps", "sync ms",
+                "undist ms", "track ms", "encode ms", "proxy ms", "total ms", "events");
+    for (auto size : { cv::Size(640, 480), cv::Size(1280, 720), cv::Size(1920, 1440) })
+        try
+        {
+            SyntheticStereo::Settings s_conf;
+            s_conf.FrameSize = size;
+            s_conf.Frames = n_frames;
+            SyntheticStereo synthetic(s_conf);
+
+            std::string name = "synthetic-" + std::to_string(size.width) + "x" + std::to_string(size.height);
+            auto files = synthetic.WriteVideos(BENCH_DIR, name);
+
+            for (int n_threads : threads)
+            {
+                cv::setNumThreads(n_threads);
+
+                auto metrics = std::make_shared<Metrics>();
+                size_t n_events = 0;
+                int64 start = cv::getTickCount();
+                int frames = RunPipeline(synthetic, files, metrics, n_events);
+                double seconds = (double)(cv::getTickCount() - start) / cv::getTickFrequency();
+
+                std::printf("%-10s %7d %8.1f %8.1f %10.2f %10.2f %10.2f %10.2f %10.2f %6zu\n",
+                            (std::to_string(size.width) + "x" + std::to_string(size.height)).c_str(), n_threads,
+                            frames / seconds, StageMs(*metrics, "sync", 1), StageMs(*metrics, "undistort", frames),
+                            StageMs(*metrics, "track", frames), StageMs(*metrics, "encode", frames),
+                            StageMs(*metrics, "proxy", frames),
+                            1000.0 * seconds / std::max(frames, 1), n_events);
+
+                metrics->Write(cv::utils::fs::join(BENCH_DIR, name + "_t" + std::to_string(n_threads) + ".json"));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << " !> " << e.what() << '\n';
+        }
+
+    return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+int RunPipeline(const SyntheticStereo& synthetic, const std::pair<std::string, std::string>& files,
+                std::shared_ptr<Metrics> metrics, size_t& n_events)
+{
+    cv::VideoCapture caps[2] = { cv::VideoCapture(files.first), cv::VideoCapture(files.second) };
+    for (auto& cap : caps)
+        if (!cap.isOpened())
+            throw std::runtime_error("Synthetic video could not be opened!");
+
+    // Both videos skip to just after their QR code, like Processor::SyncVideos.
+    {
+        Metrics::ScopedTimer timer(metrics.get(), "sync");
+        SyncEngine::Settings s_conf;
+        SyncEngine engine(s_conf);
+        engine.SetMetrics(metrics);
+        auto sync = engine.Sync(files.first, files.second);
+        if (!sync.found)
+            throw std::runtime_error("Synthetic videos did not sync!");
+        for (int i = 0; i < 2; i++)
+            caps[i].set(cv::CAP_PROP_POS_FRAMES, sync.start[i]);
+    }
+
+    // Same settings as the Processor uses.
+    Tracker::Settings t_conf;
+    t_conf.bDrawContours = false;
+    t_conf.MinThreshold = 200;
+    t_conf.CascadeDir = "";
+    t_conf.EnterFrames = 2;
+    t_conf.ExitFrames = 3;
+    t_conf.MergeGap = 15;
+    t_conf.MinEventFrames = 5;
+    Tracker tracker(t_conf);
+    tracker.SetMetrics(metrics);
+
+    cv::Mat camera_matrix = synthetic.CameraMatrix(), dist_coeffs = synthetic.DistCoeffs();
+    cv::Size out_size(2 * synthetic.Config.FrameSize.width, synthetic.Config.FrameSize.height);
+    cv::VideoWriter writer(cv::utils::fs::join(BENCH_DIR, "output.mp4"), cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+                           synthetic.Config.FPS, out_size, true);
+
+    // Same proxy as the Processor writes when enabled, if the frames are large
+    // enough.
+    cv::Size proxy_size = Processor::GetProxySize(out_size, PROXY_WIDTH);
+    cv::VideoWriter proxy;
+    if (!proxy_size.empty())
+        proxy.open(cv::utils::fs::join(BENCH_DIR, "output_proxy.mp4"), cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+                   synthetic.Config.FPS, proxy_size, true);
+
+    int frame_num = 0;
+    while (true)
+    {
+        cv::Mat frames[2];
+        {
+            Metrics::ScopedTimer timer(metrics.get(), "decode");
+            if (!caps[0].read(frames[0]) || !caps[1].read(frames[1]))
+                break;
+        }
+
+        for (int i = 0; i < 2; i++)
+        {
+            Metrics::ScopedTimer timer(metrics.get(), "undistort");
+            cv::Mat undistorted;
+            cv::undistort(frames[i], undistorted, camera_matrix, dist_coeffs);
+            frames[i] = undistorted;
+        }
+
+        {
+            Metrics::ScopedTimer timer(metrics.get(), "track");
+            for (int i = 0; i < 2; i++)
+                tracker.CreateMask(frames[i], i);
+            tracker.CheckForActivity(frame_num);
+        }
+
+        cv::Mat concatenated;
+        {
+            Metrics::ScopedTimer timer(metrics.get(), "encode");
+            cv::hconcat(frames[0], frames[1], concatenated);
+            writer << concatenated;
+        }
+        if (proxy.isOpened())
+        {
+            Metrics::ScopedTimer timer(metrics.get(), "proxy");
+            cv::Mat small;
+            cv::resize(concatenated, small, proxy_size, 0, 0, cv::INTER_AREA);
+            proxy << small;
+        }
+        frame_num++;
+    }
+
+    tracker.EndActivity(frame_num);
+    n_events = tracker.ActivityRange.size();
+    metrics->Increment("frames", frame_num);
+    metrics->Increment("events", (long)n_events);
+    return frame_num;
+}
+
+double StageMs(const Metrics& metrics, const char* stage, int frames)
+{
+    auto hist = metrics.GetStage(stage);
+    return hist ? hist->total_ms / std::max(frames, 1) : 0.0;
+}
@@ -0,0 +1,135 @@
+/// \date October 16, 2026
+///
+/// Benchmarks the tracker's background subtraction backends on a video. Every
+/// backend runs over the same frames and reports its average cost per frame,
+/// and how well its activity events agree with those of the KNN backend: the
+/// frames both consider active out of the frames either considers active.
+///
+/// Usage: bench_tracker <video> [max_frames] [backend...]
+
+#include "../resources/includes/Tracker.h"
+#include "../resources/includes/EventDetector.h"
+
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define DEFAULT_MAX_FRAMES 1000
+
+std::vector<bool> RunBackend(const std::string&, Tracker::Backend, int, double&);
+double EventAgreement(const std::vector<bool>&, const std::vector<bool>&);
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <video> [max_frames] [backend...]\n";
+        return 1;
+    }
+    int max_frames = argc > 2 ? std::atoi(argv[2]) : DEFAULT_MAX_FRAMES;
+
+    // KNN always runs first, as the reference for the other backends.
+    std::vector<Tracker::Backend> backends = { Tracker::Backend::KNN };
+    if (argc > 3)
+    {
+        for (int i = 3; i < argc; i++)
+            try
+            {
+                auto backend = Tracker::GetBackend(argv[i]);
+                if (backend != Tracker::Backend::KNN) backends.push_back(backend);
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << " !> " << e.what() << '\n';
+            }
+    }
+    else
+        backends.insert(backends.end(), { Tracker::Backend::MOG2, Tracker::Backend::GSOC, Tracker::Backend::LSBP,
+                                          Tracker::Backend::CNT, Tracker::Backend::FRAME_DIFF,
+                                          Tracker::Backend::RUNNING_AVG });
+
+    std::vector<bool> reference;
+    std::printf("%-12s %10s %8s %8s %10s\n", "backend", "ms/frame", "frames", "active", "agreement");
+    for (auto backend : backends)
+        try
+        {
+            double ms_per_frame = 0;
+            auto active = RunBackend(argv[1], backend, max_frames, ms_per_frame);
+            if (backend == Tracker::Backend::KNN) reference = active;
+
+            std::printf("%-12s %10.2f %8zu %8zu %10.3f\n", Tracker::GetBackendName(backend).c_str(),
+                        ms_per_frame, active.size(), (size_t)std::count(active.begin(), active.end(), true),
+                        EventAgreement(reference, active));
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << " !> " << e.what() << '\n';
+        }
+
+    return 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<bool> RunBackend(const std::string& file, Tracker::Backend backend, int max_frames, double& ms_per_frame)
+{
+    cv::VideoCapture cap(file);
+    if (!cap.isOpened())
+        throw std::runtime_error("Video \"" + file + "\" could not be opened!");
+
+    // Same settings as the Processor uses.
+    Tracker::Settings config;
+    config.bDrawContours = false;
+    config.MinThreshold = 200;
+    config.Subtractor = backend;
+    Tracker tracker(config);
+
+    int64 ticks = 0;
+    int frame_num = 0;
+    cv::Mat frame;
+    while (frame_num < max_frames && cap.read(frame))
+    {
+        // Only the tracker is timed, not decoding.
+        int64 start = cv::getTickCount();
+        tracker.CreateMask(frame);
+        tracker.CheckForActivity(frame_num);
+        ticks += cv::getTickCount() - start;
+        frame_num++;
+    }
+
+    std::vector<bool> active(frame_num, false);
+    for (auto& event : tracker.ActivityRange)
+    {
+        auto range = event.GetRange();
+        int end = event.IsActive() ? frame_num : std::min(range.second, frame_num);
+        for (int f = std::max(range.first, 0); f < end; f++)
+            active[f] = true;
+    }
+
+    ms_per_frame = frame_num > 0 ? 1000.0 * ticks / cv::getTickFrequency() / frame_num : 0.0;
+    return active;
+}
+
+double EventAgreement(const std::vector<bool>& reference, const std::vector<bool>& active)
+{
+    size_t both = 0, either = 0;
+    for (size_t f = 0; f < std::max(reference.size(), active.size()); f++)
+    {
+        bool a = f < reference.size() && reference[f];
+        bool b = f < active.size() && active[f];
+        both   += a && b;
+        either += a || b;
+    }
+
+    // Two backends which never see activity agree completely.
+    return either > 0 ? (double)both / either : 1.0;
+}
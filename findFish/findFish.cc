@@ -7,6 +7,7 @@
 
 #include "resources/includes/Processor.h"
 #include "resources/includes/Calibration.h"
+#include "resources/includes/TriangulationServer.h"
 
 using namespace std;
 
@@ -54,7 +55,30 @@ int main(int argc, char** argv)
         {
             std::cerr << e.what() << '\n';
         }
-        
+        else if (std::string(argv[1]) == "SERVE")
+        try
+        {
+            Calibration::Input input;
+            input.image_size = cv::Size(1920, 1440);
+
+            auto calib = std::make_shared<Calibration>(input, CalibrationType::STEREO, "stereo_calibration.yaml");
+            calib->ReadCalibration();
+
+            // Serve over a Unix socket if a path is given, otherwise over stdin/stdout.
+            TriangulationServer server(calib);
+            if (argc > 2)
+                server.Listen(argv[2]);
+            else
+            {
+                std::ios::sync_with_stdio(false);
+                server.Serve(std::cin, std::cout);
+            }
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+        }
+
 
         return 0;
     }
@@ -1,4 +1,7 @@
 #include "includes/Calibration.h"
+#include "includes/FileHash.h"
+#include "includes/StringUtils.h"
+#include "includes/JsonBuilder.h"
 
 #include <opencv2/calib3d.hpp>
 #include <opencv2/tracking.hpp>
@@ -6,12 +9,15 @@
 
 #include <iostream>
 #include <string>
-#include <regex>
 #include <algorithm>
 #include <assert.h>
 #include <stdexcept>
+#include <fstream>
 
-std::vector<std::string> Split(std::string&, const char*);
+// Extrinsic guesses are only supported from OpenCV 4.1 onward.
+#define HAS_EXTRINSIC_GUESS (CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 1))
+
+bool SameMat(const cv::Mat& a, const cv::Mat& b);
 
 Calibration::Calibration(Input& in, CalibrationType type, std::string outfile)
 {
@@ -24,6 +30,9 @@ Calibration::Calibration(Input& in, CalibrationType type, std::string outfile)
     this->_input.image_size        = in.image_size;
     this->_input.grid_size         = in.grid_size != cv::Size() ? in.grid_size : cv::Size(19, 11);
     this->_input.grid_dot_size     = in.grid_dot_size >= 1.f ? in.grid_dot_size : 13.f; // mm
+    this->_input.max_view_error    = in.max_view_error;
+    this->_input.min_views         = in.min_views;
+    this->_input.max_prune_iterations = in.max_prune_iterations;
 
     this->_type              = type;
     this->_outfile_name      = outfile;
@@ -35,25 +44,29 @@ void Calibration::ReadImages(std::string dir1, std::string dir2)
     cv::glob(dir1, _input.images[0], false);
     cv::glob(dir2, _input.images[1], false);
 
+    // Cameras are named after the last component of their image paths.
+    std::string dirs[2] = { dir1, dir2 };
+    for (int i = 0; i < 2; i++)
     {
-        auto vec = Split(dir1, "/");
-        this->_input.camera_names[0] = vec[vec.size()-1];
-    }
-    {
-        auto vec = Split(dir2, "/");
-        this->_input.camera_names[1] = vec[vec.size()-1];
+        auto vec = Tokenize(dirs[i], '/');
+        if (!vec.empty())
+            this->_input.camera_names[i] = vec.back().ToString();
     }
 }
 
 void Calibration::RunCalibration()
 {
+    _report = Report();
     try 
     {
         if (_type == CalibrationType::STEREO)
         {
             SingleCalibrate();
             StereoCalibrate();
+
+            int64 start = cv::getTickCount();
             UndistortPoints();
+            AddTiming("undistort_points", start);
         }
         else SingleCalibrate();
     }
@@ -62,6 +75,9 @@ void Calibration::RunCalibration()
         std::cerr << " !> " << e.what() << '\n';
         std::cerr << "=!= Aborted Calibration =!=\n";
     }
+
+    // Even a partial report shows which views and phases caused trouble.
+    WriteReport();
 }
 
 void Calibration::ReadCalibration()
@@ -89,27 +105,40 @@ void Calibration::ReadCalibration()
         fs["R1"] >> _result.R1;
         fs["P2"] >> _result.P2;
         fs["R2"] >> _result.R2;
+        fs["Q"]  >> _result.Q;
+
+        // Older calibration files did not store Q, so rebuild the
+        // rectification from the stereo extrinsics when it is missing.
+        if(_result.Q.empty() && !_result.R.empty() && !_result.T.empty() &&
+           !_result.CameraMatrix[0].empty() && !_result.CameraMatrix[1].empty())
+            cv::stereoRectify(_result.CameraMatrix[0], _result.DistCoeffs[0],
+                              _result.CameraMatrix[1], _result.DistCoeffs[1],
+                              _input.image_size, _result.R, _result.T,
+                              _result.R1, _result.R2, _result.P1, _result.P2, _result.Q,
+                              cv::CALIB_ZERO_DISPARITY, -1, _input.image_size);
     }
 }
 
 void Calibration::GetImagePoints()
 {
     std::cout << "=== Finding Image Points ===" << std::endl;
-   
-    for (size_t i = 0; i < (_input.images[0].size() + _input.images[1].size())/2; i++)
+
+    if (_input.image_size == cv::Size() && !_input.images[0].empty())
     {
-        std::string imageL = _input.images[0][i], imageR = _input.images[1][i];
-        cv::Mat imgL = cv::imread(imageL, cv::IMREAD_GRAYSCALE), imgR = cv::imread(imageR, cv::IMREAD_GRAYSCALE), frameL, frameR;
+        cv::Mat img = cv::imread(_input.images[0][0], cv::IMREAD_GRAYSCALE);
+        _input.image_size = img.size() != cv::Size() ? img.size() : cv::Size(1920, 1440);
+    }
 
-        if (_input.image_size == cv::Size())
-            _input.image_size = imgL.size() != cv::Size() ? imgL.size() : imgR.size() != cv::Size() ? imgR.size() : cv::Size(1920, 1440);
+    ReadDetectionCache();
+    size_t n_cached = _detections.size();
 
-        if(imgL.size() != cv::Size()) cv::resize(imgL, frameL, _input.image_size);
-        if(imgR.size() != cv::Size()) cv::resize(imgR, frameR, _input.image_size);
+    for (size_t i = 0; i < (_input.images[0].size() + _input.images[1].size())/2; i++)
+    {
+        std::string imageL = _input.images[0][i], imageR = _input.images[1][i];
 
         std::vector<cv::Point2f> bufferL, bufferR;
-        bool found_left  = cv::findCirclesGrid(frameL, cv::Size(_input.grid_size.width, _input.grid_size.height), bufferL);
-        bool found_right = cv::findCirclesGrid(frameR, cv::Size(_input.grid_size.width, _input.grid_size.height), bufferR);
+        bool found_left  = FindGrid(imageL, bufferL);
+        bool found_right = FindGrid(imageR, bufferR);
 
         if ((_type == CalibrationType::STEREO && (found_left && found_right)) ||
             (_type == CalibrationType::SINGLE && (found_left || found_right)) )
@@ -119,14 +148,17 @@ void Calibration::GetImagePoints()
 
             if(found_left)  _result.good_images.push_back(imageL);
             if(found_right) _result.good_images.push_back(imageR);
+
+            if(found_left)  _result.view_images[0].push_back(imageL);
+            if(found_right) _result.view_images[1].push_back(imageR);
         }
     }
 
-    std::vector<cv::Point3f> objs;
-    for (int i = 0; i < _input.grid_size.height; i++)
-        for (int j = 0; j < _input.grid_size.width; j++)
-            objs.push_back(cv::Point3f((float)j * _input.grid_dot_size, (float)i * _input.grid_dot_size, 0));
+    std::cout << "  > Reused " << (_used_detections.size() - (_detections.size() - n_cached))
+              << " of " << _used_detections.size() << " grid detections\n";
+    WriteDetectionCache();
 
+    std::vector<cv::Point3f> objs = GridPoints();
     while (_input.object_points.size() != _input.image_points[0].size() &&
            _input.object_points.size() != _input.image_points[1].size())
         _input.object_points.push_back(objs);
@@ -134,15 +166,122 @@ void Calibration::GetImagePoints()
     _result.n_image_pairs = _result.good_images.size() / 2;
 }
 
+bool Calibration::FindGrid(const std::string& image, std::vector<cv::Point2f>& points)
+{
+    uint64_t hash = HashFile(image);
+    std::string key = HashToString(hash);
+
+    auto it = _detections.find(key);
+    if (hash != 0 && it != _detections.end())
+    {
+        _used_detections.insert(key);
+        points = it->second.points;
+        return it->second.found;
+    }
+
+    cv::Mat img = cv::imread(image, cv::IMREAD_GRAYSCALE), frame;
+    if (img.empty()) return false;
+    cv::resize(img, frame, _input.image_size);
+
+    bool found = cv::findCirclesGrid(frame, cv::Size(_input.grid_size.width, _input.grid_size.height), points);
+    if (hash != 0)
+    {
+        _detections[key] = Detection{found, points};
+        _used_detections.insert(key);
+    }
+    return found;
+}
+
+void Calibration::ReadDetectionCache()
+{
+    _detections.clear();
+    _used_detections.clear();
+
+    cv::FileStorage fs(_out_dir + "grid_detections.yaml", cv::FileStorage::READ);
+    if (!fs.isOpened()) return;
+
+    // Detections only carry over for the same grid and image resolution.
+    cv::Size grid_size, image_size;
+    fs["grid_size"] >> grid_size;
+    fs["image_size"] >> image_size;
+    if (grid_size != _input.grid_size || image_size != _input.image_size) return;
+
+    for (auto node : fs["detections"])
+    {
+        Detection detection;
+        detection.found = (int)node["found"] != 0;
+        node["points"] >> detection.points;
+
+        // Hashes are stored with a prefix so YAML never reads them as numbers.
+        std::string key = (std::string)node["hash"];
+        _detections[key.substr(key.find('_') + 1)] = detection;
+    }
+}
+
+void Calibration::WriteDetectionCache() const
+{
+    cv::FileStorage fs(_out_dir + "grid_detections.yaml", cv::FileStorage::WRITE);
+    if (!fs.isOpened()) return;
+
+    fs << "grid_size" << _input.grid_size;
+    fs << "image_size" << _input.image_size;
+    fs << "detections" << "[";
+    for (auto& key : _used_detections)
+    {
+        const Detection& detection = _detections.at(key);
+        fs << "{" << "hash" << "fnv_" + key
+                  << "found" << (int)detection.found
+                  << "points" << detection.points << "}";
+    }
+    fs << "]";
+}
+
+void Calibration::ReadPreviousResults(Result& previous) const
+{
+    for (int i = 0; i < 2; i++)
+    {
+        cv::FileStorage fs(_out_dir + "calib_camera_" + _input.camera_names[i] + ".yaml", cv::FileStorage::READ);
+        if (!fs.isOpened()) continue;
+
+        cv::Size grid_size, resolution;
+        fs["grid_size"] >> grid_size;
+        fs["resolution"] >> resolution;
+        if (grid_size != _input.grid_size || resolution != _input.image_size) continue;
+
+        fs["K"] >> previous.CameraMatrix[i];
+        fs["D"] >> previous.DistCoeffs[i];
+    }
+
+    if (_type == CalibrationType::STEREO)
+    {
+        cv::FileStorage fs(_out_dir + _outfile_name, cv::FileStorage::READ);
+        if (!fs.isOpened()) return;
+
+        cv::Size grid_size, image_size;
+        fs["grid_size"] >> grid_size;
+        fs["image_size"] >> image_size;
+        if (grid_size != _input.grid_size || image_size != _input.image_size) return;
+
+        fs["R"] >> previous.R;
+        fs["T"] >> previous.T;
+    }
+}
+
 void Calibration::SingleCalibrate()
 {
     std::lock_guard<std::recursive_mutex> lock(_mutex);
 
+    int64 start = cv::getTickCount();
     GetImagePoints();
+    AddTiming("find_image_points", start);
+
+    Result previous;
+    ReadPreviousResults(previous);
+
     std::cout << "=== Starting Camera Calibration ===\n";
-    int i = 0;
-    for (auto image_points : _input.image_points)
+    for (int i = 0; i < 2; i++)
     {
+        const auto& image_points = _input.image_points[i];
         std::cout << "  > Calibrating Camera \"" << _input.camera_names[i] << "\"...\n";
 
         if (image_points.empty()) 
@@ -151,7 +290,6 @@ void Calibration::SingleCalibrate()
                 std::cout << " !> No image points found for this camera!\n";
             if(_type == CalibrationType::STEREO) 
                 throw std::runtime_error("No image points found for camera \"" + _input.camera_names[i] + "\"!");
-            i++;
             continue;
         }
 
@@ -166,10 +304,20 @@ void Calibration::SingleCalibrate()
         _flags |= cv::CALIB_FIX_K4;
         _flags |= cv::CALIB_FIX_K5;
 
-        double calib = calibrateCamera(_input.object_points,
-                                       image_points, _input.image_size,
-                                       _result.CameraMatrix[i], _result.DistCoeffs[i],
-                                       _result.rvecs[i], _result.tvecs[i], _flags);
+        // Adding a few images barely moves the solution, so start from the
+        // previous one instead of from scratch.
+        int flags = _flags;
+        if (!previous.CameraMatrix[i].empty() && !previous.DistCoeffs[i].empty())
+        {
+            std::cout << "  > Warm starting from previous calibration...\n";
+            previous.CameraMatrix[i].copyTo(_result.CameraMatrix[i]);
+            previous.DistCoeffs[i].copyTo(_result.DistCoeffs[i]);
+            flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+        }
+
+        start = cv::getTickCount();
+        double calib = CalibrateCamera(i, flags);
+        AddTiming("calibrate_camera_" + _input.camera_names[i], start);
         std::cout << "  > Calibration Result: " << calib << std::endl;
 
 
@@ -181,8 +329,6 @@ void Calibration::SingleCalibrate()
         fs << "grid_dot_size" << _input.grid_dot_size;
         fs << "resolution" << _input.image_size;
         std::cout << "  > Finished Camera " << std::to_string(i) << " calibration\n";
-
-        i++;
     }
     std::cout << "=== Finished Calibration ===" << std::endl;
 }
@@ -205,24 +351,77 @@ void Calibration::StereoCalibrate()
     _flags |= cv::CALIB_USE_INTRINSIC_GUESS;
     _flags |= cv::CALIB_SAME_FOCAL_LENGTH;
 
-    double rms = cv::stereoCalibrate(_input.object_points,
-                                     _input.image_points[0],
-                                     _input.image_points[1],
-                                     _result.CameraMatrix[0],// Intrinsic Matrix Left
-                                     _result.DistCoeffs[0],
-                                     _result.CameraMatrix[1],// Intrinsic Matrix Right
-                                     _result.DistCoeffs[1],
-                                     _input.image_size,
-                                     _result.R,              // 3x3 Rotation Matrix
-                                     _result.T,              // 3x1 Translation Vector (Column Vector)
-                                     _result.E,              // Essential Matrix
-                                     _result.F,              // Fundamental Matrix
-                                     _flags,
-                                     cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-5));
+#if HAS_EXTRINSIC_GUESS
+    Result previous;
+    ReadPreviousResults(previous);
+    if (!previous.R.empty() && !previous.T.empty())
+    {
+        std::cout << "  > Warm starting from previous stereo calibration...\n";
+        previous.R.copyTo(_result.R);
+        previous.T.copyTo(_result.T);
+        _flags |= cv::CALIB_USE_EXTRINSIC_GUESS;
+    }
+#endif
+
+    int64 start = cv::getTickCount();
+    Report::Solve solve;
+    solve.name = "stereo";
+
+    double rms = 0;
+    for (int iteration = 0; ; iteration++)
+    {
+        _input.object_points.assign(_input.image_points[0].size(), GridPoints());
+
+        cv::Mat view_errors;
+        rms = cv::stereoCalibrate(_input.object_points,
+                                  _input.image_points[0],
+                                  _input.image_points[1],
+                                  _result.CameraMatrix[0],// Intrinsic Matrix Left
+                                  _result.DistCoeffs[0],
+                                  _result.CameraMatrix[1],// Intrinsic Matrix Right
+                                  _result.DistCoeffs[1],
+                                  _input.image_size,
+                                  _result.R,              // 3x3 Rotation Matrix
+                                  _result.T,              // 3x1 Translation Vector (Column Vector)
+                                  _result.E,              // Essential Matrix
+                                  _result.F,              // Fundamental Matrix
+                                  view_errors,            // Per view errors, one column per camera
+                                  _flags,
+                                  cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-5));
+
+        std::vector<bool> drop = FindOutlierViews(view_errors, iteration);
+        bool pruned = std::find(drop.begin(), drop.end(), true) != drop.end();
+        for (size_t v = 0; v < drop.size(); v++)
+            if (drop[v] || !pruned)
+                solve.views.push_back(Report::View{ { _result.view_images[0][v], _result.view_images[1][v] },
+                                                    { view_errors.at<double>(v, 0), view_errors.at<double>(v, 1) },
+                                                    drop[v] });
+        if (!pruned) break;
+
+        std::cout << "  > Stereo Calibration Result: " << rms << ", pruning "
+                  << std::count(drop.begin(), drop.end(), true) << " outlier pairs...\n";
+        RemoveViews(0, drop);
+#if HAS_EXTRINSIC_GUESS
+        _flags |= cv::CALIB_USE_EXTRINSIC_GUESS;
+#endif
+    }
+    AddTiming("stereo_calibrate", start);
 
+    solve.rms = rms;
+    _report.solves.push_back(solve);
     std::cout << "  > Stereo Calibration Result: " << rms << std::endl;
 
+    // Keep the pair bookkeeping in line with the views that survived pruning.
+    _result.n_image_pairs = _input.image_points[0].size();
+    _result.good_images.clear();
+    for (size_t v = 0; v < _result.view_images[0].size(); v++)
+    {
+        _result.good_images.push_back(_result.view_images[0][v]);
+        _result.good_images.push_back(_result.view_images[1][v]);
+    }
+
     std::cout << "  > Rectifying stereo..." << std::endl;
+    start = cv::getTickCount();
     cv::stereoRectify(_result.CameraMatrix[0],
                       _result.DistCoeffs[0],
                       _result.CameraMatrix[1],
@@ -236,6 +435,7 @@ void Calibration::StereoCalibrate()
                       _result.P2,
                       _result.Q,
                       cv::CALIB_ZERO_DISPARITY, -1, _input.image_size);
+    AddTiming("rectify", start);
 
     // Save calibration to yaml file to be used elsewhere.
     cv::FileStorage fs(_out_dir + _outfile_name, cv::FileStorage::WRITE);
@@ -251,12 +451,175 @@ void Calibration::StereoCalibrate()
     fs << "R1" << _result.R1;
     fs << "P2" << _result.P2;
     fs << "R2" << _result.R2;
+    fs << "Q" << _result.Q;
     fs << "grid_size" << _input.grid_size;
     fs << "grid_dot_size" << _input.grid_dot_size;
     fs << "image_size" << _input.image_size;
     std::cout << "=== Finished Stereo Calibration ===" << std::endl;
 }
 
+double Calibration::CalibrateCamera(int index, int flags)
+{
+    Report::Solve solve;
+    solve.name = "camera_" + _input.camera_names[index];
+
+    double rms = 0;
+    for (int iteration = 0; ; iteration++)
+    {
+        std::vector<std::vector<cv::Point3f>> object_points(_input.image_points[index].size(), GridPoints());
+
+        cv::Mat std_intrinsics, std_extrinsics, view_errors;
+        rms = cv::calibrateCamera(object_points, _input.image_points[index], _input.image_size,
+                                  _result.CameraMatrix[index], _result.DistCoeffs[index],
+                                  _result.rvecs[index], _result.tvecs[index],
+                                  std_intrinsics, std_extrinsics, view_errors, flags);
+
+        // Dropped views are reported with the error that got them dropped,
+        // the remaining ones with their error in the final solve.
+        std::vector<bool> drop = FindOutlierViews(view_errors, iteration);
+        bool pruned = std::find(drop.begin(), drop.end(), true) != drop.end();
+        for (size_t v = 0; v < drop.size(); v++)
+            if (drop[v] || !pruned)
+                solve.views.push_back(Report::View{ { _result.view_images[index][v], "" },
+                                                    { view_errors.at<double>(v, 0), 0 },
+                                                    drop[v] });
+        if (!pruned) break;
+
+        std::cout << "  > Calibration Result: " << rms << ", pruning "
+                  << std::count(drop.begin(), drop.end(), true) << " outlier views...\n";
+        RemoveViews(index, drop);
+
+        // The current solution is a good starting point for the next solve.
+        flags |= cv::CALIB_USE_INTRINSIC_GUESS;
+    }
+
+    solve.rms = rms;
+    _report.solves.push_back(solve);
+    return rms;
+}
+
+std::vector<bool> Calibration::FindOutlierViews(const cv::Mat& errors, int iteration) const
+{
+    std::vector<bool> drop(errors.rows, false);
+    if (iteration >= _input.max_prune_iterations || (size_t)errors.rows <= _input.min_views)
+        return drop;
+
+    // A stereo pair is only as good as its worst view.
+    std::vector<std::pair<double, int>> outliers;
+    for (int v = 0; v < errors.rows; v++)
+    {
+        double error = 0;
+        for (int c = 0; c < errors.cols; c++)
+            error = std::max(error, errors.at<double>(v, c));
+        if (error > _input.max_view_error)
+            outliers.push_back(std::make_pair(error, v));
+    }
+
+    // Drop the worst views first, without going below the minimum view count.
+    std::sort(outliers.rbegin(), outliers.rend());
+    size_t n_drop = std::min(outliers.size(), (size_t)errors.rows - _input.min_views);
+    for (size_t i = 0; i < n_drop; i++)
+        drop[outliers[i].second] = true;
+
+    return drop;
+}
+
+void Calibration::RemoveViews(int index, const std::vector<bool>& drop)
+{
+    // Stereo views are pairs, so a bad view removes the images of both cameras.
+    int first = _type == CalibrationType::STEREO ? 0 : index;
+    int last  = _type == CalibrationType::STEREO ? 1 : index;
+    for (int i = first; i <= last; i++)
+    {
+        size_t kept = 0;
+        for (size_t v = 0; v < drop.size(); v++)
+            if (!drop[v])
+            {
+                _input.image_points[i][kept] = std::move(_input.image_points[i][v]);
+                _result.view_images[i][kept] = std::move(_result.view_images[i][v]);
+                kept++;
+            }
+        _input.image_points[i].resize(kept);
+        _result.view_images[i].resize(kept);
+    }
+
+    if (_type == CalibrationType::STEREO)
+        _input.object_points.resize(_input.image_points[0].size());
+}
+
+void Calibration::AddTiming(const std::string& phase, int64 start)
+{
+    _report.timings.push_back(std::make_pair(phase, (cv::getTickCount() - start) / cv::getTickFrequency()));
+}
+
+void Calibration::WriteReport() const
+{
+    JSON report("CalibrationReport");
+
+    double total = 0;
+    std::map<std::string, std::string> timings;
+    for (auto& timing : _report.timings)
+    {
+        timings.insert(std::make_pair(timing.first, std::to_string(timing.second)));
+        total += timing.second;
+    }
+    timings.insert(std::make_pair("total", std::to_string(total)));
+    report.AddObject(JSON("timings_seconds", timings));
+
+    for (auto& solve : _report.solves)
+    {
+        JSON views("views");
+        int n_dropped = 0;
+        for (size_t v = 0; v < solve.views.size(); v++)
+        {
+            const Report::View& view = solve.views[v];
+            std::map<std::string, std::string> info;
+            if (view.images[1].empty())
+            {
+                info.insert(std::make_pair("image", view.images[0]));
+                info.insert(std::make_pair("error", std::to_string(view.errors[0])));
+            }
+            else for (int c = 0; c < 2; c++)
+            {
+                info.insert(std::make_pair("image_" + _input.camera_names[c], view.images[c]));
+                info.insert(std::make_pair("error_" + _input.camera_names[c], std::to_string(view.errors[c])));
+            }
+            info.insert(std::make_pair("dropped", view.dropped ? "1" : "0"));
+            n_dropped += view.dropped;
+
+            views.AddObject(JSON("view_" + std::to_string(v), info));
+        }
+        views.BuildJSONObjectArray();
+
+        // The subobjects must be added before the parent is copied into the report.
+        JSON solve_json(solve.name);
+        solve_json.AddKeyValue("rms", std::to_string(solve.rms));
+        solve_json.AddKeyValue("n_views", std::to_string(solve.views.size() - n_dropped));
+        solve_json.AddKeyValue("n_dropped", std::to_string(n_dropped));
+        solve_json.AddObject(views);
+        solve_json.BuildJSONObject();
+        report.AddObject(solve_json);
+    }
+    report.BuildJSONObject();
+
+    std::ofstream file(_out_dir + "calibration_report.json");
+    if (!file.is_open())
+    {
+        std::cerr << " !> Could not write calibration report!\n";
+        return;
+    }
+    file << report.GetJSON() << std::endl;
+}
+
+std::vector<cv::Point3f> Calibration::GridPoints() const
+{
+    std::vector<cv::Point3f> objs;
+    for (int i = 0; i < _input.grid_size.height; i++)
+        for (int j = 0; j < _input.grid_size.width; j++)
+            objs.push_back(cv::Point3f((float)j * _input.grid_dot_size, (float)i * _input.grid_dot_size, 0));
+    return objs;
+}
+
 void Calibration::GetUndistortedImage() const
 {
     if(_result.CameraMatrix[0].empty() || _result.CameraMatrix[1].empty())
@@ -302,13 +665,96 @@ void Calibration::UndistortImage(cv::Mat& img, int index) const
     if(index < 2 && !img.empty())
     {
         cv::Mat uimg;
-        cv::Mat frame;
-        cv::resize(img, frame, _input.image_size);
-        cv::undistort(frame, uimg, _result.CameraMatrix[index], _result.DistCoeffs[index]);
+        UndistortImage(img, uimg, index);
         img = uimg;
     }
 }
 
+void Calibration::UndistortImage(const cv::Mat& img, cv::Mat& dst, int index) const
+{
+    if(index >= 2 || img.empty())
+    {
+        dst = img;
+        return;
+    }
+    if(_result.CameraMatrix[index].empty() || _result.DistCoeffs[index].empty())
+        throw std::runtime_error("Camera Matrix [" + std::to_string(index) +"] is empty!");
+
+    cv::Mat map1, map2;
+    {
+        std::lock_guard<std::mutex> lock(_undistort_mutex);
+        UndistortMaps& maps = _undistort[index];
+        const cv::Mat& K = _result.CameraMatrix[index];
+        const cv::Mat& D = _result.DistCoeffs[index];
+        if(maps.source != img.size() || maps.map1.empty() || !SameMat(maps.camera_matrix, K) ||
+           !SameMat(maps.dist_coeffs, D))
+        {
+            // The maps sample the source image directly, so the resize to the
+            // calibrated size happens in the same interpolation.
+            cv::Mat map_x, map_y;
+            cv::initUndistortRectifyMap(K, D, cv::Mat(), K, _input.image_size, CV_32FC1, map_x, map_y);
+            double sx = (double)img.cols / _input.image_size.width, sy = (double)img.rows / _input.image_size.height;
+            map_x.convertTo(map_x, CV_32FC1, sx, 0.5 * sx - 0.5);
+            map_y.convertTo(map_y, CV_32FC1, sy, 0.5 * sy - 0.5);
+
+            maps.source = img.size();
+            K.copyTo(maps.camera_matrix);
+            D.copyTo(maps.dist_coeffs);
+            cv::convertMaps(map_x, map_y, maps.map1, maps.map2, CV_16SC2);
+        }
+        map1 = maps.map1;
+        map2 = maps.map2;
+    }
+    cv::remap(img, dst, map1, map2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+}
+
+std::vector<cv::Point2f> Calibration::RectifyPoints(const std::vector<cv::Point2f>& points, int index) const
+{
+    if(!IsStereoCalibrated())
+        throw std::runtime_error("No stereo rectification loaded!");
+
+    std::vector<cv::Point2f> rectified;
+    if(points.empty()) return rectified;
+
+    // The frames were already undistorted with the camera matrix, so only the
+    // rectifying rotation and projection remain to be applied.
+    cv::undistortPoints(points, rectified,
+                        _result.CameraMatrix[index], cv::noArray(),
+                        index == 0 ? _result.R1 : _result.R2,
+                        index == 0 ? _result.P1 : _result.P2);
+    return rectified;
+}
+
+void Calibration::GetRectifyMaps(int index, cv::Mat& map1, cv::Mat& map2) const
+{
+    if(!IsStereoCalibrated())
+        throw std::runtime_error("No stereo rectification loaded!");
+
+    // Like RectifyPoints, the maps start from an already undistorted frame.
+    cv::initUndistortRectifyMap(_result.CameraMatrix[index], cv::noArray(),
+                                index == 0 ? _result.R1 : _result.R2,
+                                index == 0 ? _result.P1 : _result.P2,
+                                _input.image_size, CV_16SC2, map1, map2);
+}
+
+cv::Point3f Calibration::ReprojectDisparity(const cv::Point2f& point, float disparity) const
+{
+    if(_result.Q.empty())
+        throw std::runtime_error("No disparity-to-depth mapping loaded!");
+
+    std::vector<cv::Point3d> in(1, cv::Point3d(point.x, point.y, disparity)), out;
+    cv::perspectiveTransform(in, out, _result.Q);
+
+    return cv::Point3f((float)out[0].x, (float)out[0].y, (float)out[0].z);
+}
+
+bool Calibration::IsStereoCalibrated() const
+{
+    return !_result.CameraMatrix[0].empty() && !_result.CameraMatrix[1].empty() &&
+           !_result.R1.empty() && !_result.R2.empty() &&
+           !_result.P1.empty() && !_result.P2.empty();
+}
+
 void Calibration::UndistortPoints()
 {
     if(_result.CameraMatrix[0].empty() || _result.CameraMatrix[1].empty())
@@ -337,10 +783,6 @@ void Calibration::UndistortPoints()
 
 void Calibration::TriangulatePoints()
 {
-    cv::Mat P1_32FC1, P2_32FC1;
-    _result.P1.convertTo(P1_32FC1, CV_32FC1);
-    _result.P2.convertTo(P2_32FC1, CV_32FC1);
-
     if(_result.undistorted_points[0].empty() || _result.undistorted_points[1].empty())
     {
         if(_input.image_points[0].empty() || _input.image_points[1].empty())
@@ -353,16 +795,10 @@ void Calibration::TriangulatePoints()
     std::cout << "=== Starting Triangulation ===\n";
     std::cout << "  > Triangulating points...\n";
 
-    cv::Mat homogeneous_points[_result.n_image_pairs];
-    for (int i = 0; i < _result.n_image_pairs; i++)
-        cv::triangulatePoints(P1_32FC1, P2_32FC1,
-                              _result.undistorted_points[0][i], // Left
-                              _result.undistorted_points[1][i], // Right
-                              homogeneous_points[i]);
-
     _result.object_points.resize(_result.n_image_pairs);
-    for(int i = 0; i < _result.n_image_pairs; i++)
-        cv::convertPointsFromHomogeneous(homogeneous_points[i].t(), _result.object_points[i]);
+    for (int i = 0; i < _result.n_image_pairs; i++)
+        _result.object_points[i] = TriangulatePoints(_result.undistorted_points[0][i],  // Left
+                                                     _result.undistorted_points[1][i]); // Right
 
     cv::FileStorage fs(_out_dir + "object_points.yaml", cv::FileStorage::WRITE);
     fs << "object_points" << _result.object_points;
@@ -370,26 +806,37 @@ void Calibration::TriangulatePoints()
     std::cout << "=== Finished Triangulation ===" << std::endl;
 }
 
+std::vector<cv::Point3f> Calibration::TriangulatePoints(const std::vector<cv::Point2f>& left,
+                                                        const std::vector<cv::Point2f>& right) const
+{
+    if(_result.P1.empty() || _result.P2.empty())
+        throw std::runtime_error("No stereo projection matrices loaded!");
+
+    if(left.size() != right.size())
+        throw std::runtime_error("Left and right point counts do not match!");
+
+    std::vector<cv::Point3f> world_points;
+    if(left.empty()) return world_points;
+
+    cv::Mat P1_32FC1, P2_32FC1;
+    _result.P1.convertTo(P1_32FC1, CV_32FC1);
+    _result.P2.convertTo(P2_32FC1, CV_32FC1);
+
+    cv::Mat homogeneous_points;
+    cv::triangulatePoints(P1_32FC1, P2_32FC1, left, right, homogeneous_points);
+    cv::convertPointsFromHomogeneous(homogeneous_points.t(), world_points);
+
+    return world_points;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Helper Functions
 ///////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::string> Split(std::string& str, const char* delimiter)
+bool SameMat(const cv::Mat& a, const cv::Mat& b)
 {
-    std::vector<std::string> _result;
-    size_t i = 0;
-    std::string temp = str;
-
-    std::regex r("\\s+");
-    while ((i = temp.find(delimiter)) != std::string::npos)
-    {
-        if (i > str.length())
-            i = str.length() - 1;
-        _result.push_back(regex_replace(temp.substr(0, i), r, ""));
-        temp.erase(0, i + 1);
-    }
-    if(regex_replace(temp.substr(0, i), r, "") != "") 
-        _result.push_back(regex_replace(temp.substr(0, i), r, ""));
-
-    return _result;
-}
\ No newline at end of file
+    if(a.size() != b.size() || a.type() != b.type())
+        return false;
+    return a.empty() || cv::norm(a, b, cv::NORM_INF) == 0;
+}
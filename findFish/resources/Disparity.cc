@@ -0,0 +1,104 @@
+#include "includes/Disparity.h"
+#include "includes/Calibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+Disparity::Disparity(std::shared_ptr<Calibration> calib, Settings settings)
+    : Config{settings}, _calib{calib}
+{
+    if(!_calib || !_calib->IsStereoCalibrated())
+        throw std::runtime_error("Disparity needs a stereo calibration!");
+
+    // SGBM needs a positive multiple of 16 disparities and an odd block size.
+    Config.SearchRange = std::max(16, (Config.SearchRange + 15) / 16 * 16);
+    Config.BlockSize   = std::max(1, Config.BlockSize | 1);
+
+    for(int i = 0; i < 2; i++)
+        _calib->GetRectifyMaps(i, _maps[i][0], _maps[i][1]);
+
+    int area = Config.BlockSize * Config.BlockSize;
+    _matcher = cv::StereoSGBM::create(-Config.SearchRange / 2, Config.SearchRange, Config.BlockSize,
+                                      8 * area, 32 * area, 1, 63, 10, 100, 2,
+                                      cv::StereoSGBM::MODE_SGBM_3WAY);
+
+    if(Config.bUseWLS)
+    {
+        _right_matcher = cv::ximgproc::createRightMatcher(_matcher);
+        _wls = cv::ximgproc::createDisparityWLSFilter(_matcher);
+        _wls->setLambda(Config.WLSLambda);
+        _wls->setSigmaColor(Config.WLSSigma);
+    }
+}
+
+float Disparity::EstimateDepth(const cv::Mat& left, const cv::Mat& right,
+                               const cv::Rect2f& left_box, const cv::Rect2f& right_box) const
+{
+    if(left.empty() || right.empty()) return -1.f;
+
+    // The horizontal offset between the matched boxes is already a coarse
+    // disparity, so only the residual around it has to be searched.
+    int shift = cvRound((left_box.x + left_box.width / 2.f) - (right_box.x + right_box.width / 2.f));
+
+    // SGBM cannot match the leftmost columns of its input, so the region is
+    // padded on the left by the full search range.
+    int x0 = cvFloor(left_box.x) - Config.Padding - Config.SearchRange;
+    int y0 = cvFloor(std::min(left_box.y, right_box.y)) - Config.Padding;
+    int x1 = cvCeil(left_box.x + left_box.width) + Config.Padding;
+    int y1 = cvCeil(std::max(left_box.y + left_box.height, right_box.y + right_box.height)) + Config.Padding;
+
+    // Both the left region and the shifted right region must be in the frame.
+    int width = _maps[0][0].cols, height = _maps[0][0].rows;
+    x0 = std::max(x0, std::max(0, shift));
+    x1 = std::min(x1, std::min(width, width + shift));
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, height);
+    if(x1 - x0 <= Config.SearchRange || y1 - y0 <= Config.BlockSize)
+        return -1.f;
+
+    cv::Rect roi_left(x0, y0, x1 - x0, y1 - y0);
+    cv::Rect roi_right(x0 - shift, y0, x1 - x0, y1 - y0);
+
+    // Rectify only the regions of interest.
+    cv::Mat patches[2];
+    cv::remap(left, patches[0], _maps[0][0](roi_left), _maps[0][1](roi_left), cv::INTER_LINEAR);
+    cv::remap(right, patches[1], _maps[1][0](roi_right), _maps[1][1](roi_right), cv::INTER_LINEAR);
+    for(auto& patch : patches)
+        if(patch.channels() == 3)
+            cv::cvtColor(patch, patch, cv::COLOR_BGR2GRAY);
+
+    cv::Mat disparity;
+    _matcher->compute(patches[0], patches[1], disparity);
+    if(_wls)
+    {
+        cv::Mat right_disparity, filtered;
+        _right_matcher->compute(patches[1], patches[0], right_disparity);
+        _wls->filter(disparity, patches[0], filtered, right_disparity);
+        disparity = filtered;
+    }
+
+    // Take the median of all valid disparities inside the object's box.
+    cv::Rect object(cvFloor(left_box.x) - x0, cvFloor(left_box.y) - y0,
+                    cvCeil(left_box.width), cvCeil(left_box.height));
+    object &= cv::Rect(0, 0, disparity.cols, disparity.rows);
+
+    const short invalid = (short)((-Config.SearchRange / 2 - 1) * 16);
+    std::vector<short> values;
+    values.reserve(object.area());
+    for(int y = object.y; y < object.y + object.height; y++)
+    {
+        const short* row = disparity.ptr<short>(y);
+        for(int x = object.x; x < object.x + object.width; x++)
+            if(row[x] > invalid) values.push_back(row[x]);
+    }
+    if(values.empty()) return -1.f;
+
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    float d = values[values.size() / 2] / 16.f + shift;
+    if(std::abs(d) < 0.5f) return -1.f;
+
+    cv::Point2f centre(left_box.x + left_box.width / 2.f, left_box.y + left_box.height / 2.f);
+    return std::abs(_calib->ReprojectDisparity(centre, d).z);
+}
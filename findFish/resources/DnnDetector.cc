@@ -0,0 +1,128 @@
+#include "includes/DnnDetector.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Values per detection in the output of an SSD DetectionOutput layer:
+// [image_id, label, confidence, left, top, right, bottom].
+#define DETECTION_SIZE 7
+
+double ElapsedMs(int64 start);
+
+DnnDetector::DnnDetector(DnnDetector::Settings settings)
+    : Config{settings}, _output_checked{false}
+{
+    _net = cv::dnn::readNet(Config.Model, Config.ConfigFile);
+    if(_net.empty())
+        throw std::runtime_error("Could not load detector network \"" + Config.Model + "\"!");
+
+    _net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    _net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+    _pending.reserve(std::max(Config.BatchSize, 1));
+}
+
+void DnnDetector::Add(const cv::Mat& frame, const cv::Rect& box, int frame_num, int camera)
+{
+    if(frame.empty()) return;
+
+    auto start = cv::getTickCount();
+
+    // Grow the box, as the mask rarely covers the whole fish.
+    int pad_x = (int)(box.width * Config.Padding), pad_y = (int)(box.height * Config.Padding);
+    cv::Rect roi = cv::Rect(box.x - pad_x, box.y - pad_y, box.width + 2 * pad_x, box.height + 2 * pad_y) &
+                   cv::Rect(0, 0, frame.cols, frame.rows);
+    if(roi.area() == 0) return;
+
+    // Resizing now keeps the queue small and independent of the frame.
+    Region region{ frame_num, camera, roi, cv::Mat() };
+    cv::resize(frame(roi), region.image, Config.InputSize);
+    _pending.push_back(region);
+
+    _timings.preprocess_ms += ElapsedMs(start);
+
+    if((int)_pending.size() >= Config.BatchSize)
+        RunBatch();
+}
+
+std::vector<Detection> DnnDetector::Flush()
+{
+    RunBatch();
+
+    std::vector<Detection> detections;
+    detections.swap(_detections);
+    return detections;
+}
+
+const DnnDetector::Timings& DnnDetector::GetTimings() const
+{
+    return _timings;
+}
+
+void DnnDetector::RunBatch()
+{
+    if(_pending.empty()) return;
+
+    auto start = cv::getTickCount();
+    std::vector<cv::Mat> images;
+    images.reserve(_pending.size());
+    for(auto& region : _pending)
+        images.push_back(region.image);
+
+    cv::Mat blob = cv::dnn::blobFromImages(images, Config.Scale, Config.InputSize, Config.Mean, Config.bSwapRB, false);
+    _timings.preprocess_ms += ElapsedMs(start);
+
+    start = cv::getTickCount();
+    _net.setInput(blob);
+    cv::Mat output = _net.forward();
+    _timings.forward_ms += ElapsedMs(start);
+
+    // Any other layout would be cut into records all the same, so the
+    // network is refused instead of reporting nonsense boxes.
+    if(!_output_checked)
+    {
+        if(output.type() != CV_32F || output.dims != 4 || output.size[3] != DETECTION_SIZE)
+            throw std::runtime_error("Detector network \"" + Config.Model + "\" does not end in an SSD DetectionOutput layer!");
+        _output_checked = true;
+    }
+
+    // Every detection of the batch names the image it came from, with its
+    // corners normalized to that image.
+    start = cv::getTickCount();
+    const float* data = output.ptr<float>();
+    size_t n_detections = output.total() / DETECTION_SIZE;
+    for(size_t i = 0; i < n_detections; i++)
+    {
+        const float* det = data + i * DETECTION_SIZE;
+        int image = (int)det[0];
+        float score = det[2];
+        if(image < 0 || image >= (int)_pending.size() || score < Config.ConfidenceThreshold)
+            continue;
+
+        const Region& region = _pending[image];
+        auto left = std::max(0.f, std::min(det[3], 1.f)), top = std::max(0.f, std::min(det[4], 1.f));
+        auto right = std::max(0.f, std::min(det[5], 1.f)), bottom = std::max(0.f, std::min(det[6], 1.f));
+
+        cv::Rect box((int)(region.roi.x + left * region.roi.width),
+                     (int)(region.roi.y + top * region.roi.height),
+                     (int)((right - left) * region.roi.width),
+                     (int)((bottom - top) * region.roi.height));
+        if(box.area() > 0)
+            _detections.push_back(Detection{ region.frame, region.camera, (int)det[1], score, box });
+    }
+    _timings.postprocess_ms += ElapsedMs(start);
+
+    _timings.batches++;
+    _timings.regions += (int)_pending.size();
+    _pending.clear();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+double ElapsedMs(int64 start)
+{
+    return (double)(cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
@@ -1,14 +1,20 @@
 #include "includes/EventDetector.h"
 #include "includes/JsonBuilder.h"
+#include "includes/StringUtils.h"
 
+#include <algorithm>
+#include <iterator>
 #include <vector>
-#include <regex>
 
 using namespace cv;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Forward Declarations
-std::vector<std::string> SplitString(std::string& str, const char* delimiter);
+float Median(std::vector<float> values);
+JSON TrackToJSON(const ObjectTrack& track, const std::vector<float>& depths);
+std::string DetectionsToJSON(const std::vector<Detection>& detections);
+std::string DepthsToJSON(const std::vector<ObjectDepth>& depths);
+JSON ThumbnailsToJSON(const EventThumbnails& thumbnails);
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -16,16 +22,10 @@ std::vector<std::string> SplitString(std::string& str, const char* delimiter);
 EventBuilder::EventBuilder() 
     : _start_frame{ -1 }, _end_frame{ -1 }
 {
-    _json_object = std::make_unique<JSON>("");
 }
 
 EventBuilder::~EventBuilder() {}
 
-const JSON EventBuilder::GetAsJSON()
-{
-    return *_json_object.get();
-}
-
 std::pair<int, int> EventBuilder::GetRange() const
 {
     return std::make_pair(_start_frame, _end_frame);
@@ -37,21 +37,15 @@ QREvent::QREvent() : EventBuilder() {}
 
 void QREvent::CheckFrame(cv::Mat& frame, int& currFrame)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-
-    _frame = frame;
-    if(!_frame.empty())
+    if(!frame.empty())
     {
         QRCodeDetector qrDetector;
         Mat boundBox;
-        std::string url = qrDetector.detectAndDecode(_frame, boundBox);
+        std::string url = qrDetector.detectAndDecode(frame, boundBox);
         if (url.length() > 0 && !DetectedQR()) 
         {
             StartEvent(currFrame);
-            auto info = GetGeoURIValues(url);
-            info.insert(std::make_pair("frame", std::to_string(_start_frame)));
-            _json_object = std::make_unique<JSON>("Event_QRCode", info);
-
+            url_ = url;
             EndEvent(currFrame);
         }
     }  
@@ -72,24 +66,35 @@ const bool QREvent::DetectedQR() const
     return (_start_frame != -1 && _end_frame != -1);
 }
 
-std::map<std::string, std::string> QREvent::GetGeoURIValues(std::string& uri) const
+JSON QREvent::GetAsJSON() const
+{
+    if(url_.empty()) return JSON("");
+
+    auto info = GetGeoURIValues(url_);
+    info.insert(std::make_pair("frame", std::to_string(_start_frame)));
+    return JSON("Event_QRCode", info);
+}
+
+std::map<std::string, std::string> QREvent::GetGeoURIValues(std::string uri)
 {
     std::map<std::string, std::string> json;
     
-    auto strings = SplitString(uri, ";");
-    for(auto str : strings)
+    for(auto str : Tokenize(uri, ';'))
     {
-        if(str.find("geo:") != std::string::npos)
+        size_t geo = str.Find("geo:");
+        if(geo != std::string::npos)
         {
-            str = str.substr(str.find("geo:")+4, str.length());
-            auto values = SplitString(str, ",");
-            
-            json.insert(std::make_pair("lat", values[0]));
-            json.insert(std::make_pair("long", values[1]));
+            str = str.Substr(geo + 4);
+            auto values = Tokenize(str, ',');
+            if(values.size() >= 2)
+            {
+                json.insert(std::make_pair("lat", values[0].ToString()));
+                json.insert(std::make_pair("long", values[1].ToString()));
+            }
         }
-        auto values = SplitString(str, "=");
-        for(size_t i = 0; i < values.size()-1; i+=2)
-            json.insert(std::make_pair(values[i], values[i+1]));
+        auto values = Tokenize(str, '=');
+        for(size_t i = 0; i + 1 < values.size(); i+=2)
+            json.insert(std::make_pair(values[i].ToString(), values[i+1].ToString()));
     }
     
     return json;
@@ -107,26 +112,106 @@ ActivityEvent::ActivityEvent(int id, int start, int end) : EventBuilder(), id_{i
 
 void ActivityEvent::CheckFrame(cv::Mat& frame, int& currFrame)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
 }
 
 void ActivityEvent::StartEvent(int& currFrame)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     if(_start_frame == -1) _start_frame = currFrame;
 }
 
 void ActivityEvent::EndEvent(int& currFrame)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
     if(IsActive()) _end_frame = currFrame;
-    if(_start_frame != -1 && _end_frame != -1)
+}
+
+JSON ActivityEvent::GetAsJSON() const
+{
+    if(_start_frame == -1 || _end_frame == -1) return JSON("");
+
+    ActivitySummary summary = Summary();
+    JSON json("Event_Activity_" + std::to_string(id_));
+    json.AddKeyValue("frame_start", std::to_string(summary.frame_start));
+    json.AddKeyValue("frame_end", std::to_string(summary.frame_end));
+    if(summary.length_samples > 0)
+    {
+        json.AddKeyValue("length_mm", std::to_string(summary.length_mm));
+        json.AddKeyValue("length_samples", std::to_string(summary.length_samples));
+    }
+    if(!tracks_.empty())
+        json.AddKeyValue("n_objects", std::to_string(summary.n_objects));
+    if(!detections_.empty())
+        json.AddRawValue("detections", DetectionsToJSON(detections_));
+
+    // Number of detections of every species candidate.
+    if(!species_.empty())
+    {
+        JSON counts("species");
+        for(auto& species : species_)
+            counts.AddKeyValue(species.first, std::to_string(species.second));
+        counts.BuildJSONObject();
+        json.AddObject(counts);
+    }
+
+    // Previews are only listed once they were written.
+    if(!thumbnails_.strip_file.empty() || !thumbnails_.keyframe_file.empty())
+        json.AddObject(ThumbnailsToJSON(thumbnails_));
+
+    // Depths are estimated for the boxes of the left camera, so they belong
+    // to the left track with that box in that frame.
+    std::vector<std::vector<float>> track_depths(tracks_.size());
+    std::vector<ObjectDepth> untracked;
+    for(auto& depth : depths_)
+    {
+        bool bTracked = false;
+        for(size_t i = 0; i < tracks_.size() && !bTracked; i++)
+            if(tracks_[i].camera == 0)
+                for(auto& box : tracks_[i].boxes)
+                    if(box.first == depth.frame && box.second == depth.box)
+                    {
+                        track_depths[i].push_back(depth.depth_mm);
+                        bTracked = true;
+                        break;
+                    }
+        if(!bTracked) untracked.push_back(depth);
+    }
+    if(!untracked.empty())
+        json.AddRawValue("depths", DepthsToJSON(untracked));
+
+    if(!tracks_.empty())
     {
-        std::map<std::string, std::string> info;
-        info.insert(std::make_pair("frame_start", std::to_string(_start_frame)));
-        info.insert(std::make_pair("frame_end", std::to_string(_end_frame)));
-        _json_object = std::make_unique<JSON>("Event_Activity_"+std::to_string(id_), info);
+        JSON tracks("tracks");
+        for(size_t i = 0; i < tracks_.size(); i++)
+            tracks.AddObject(TrackToJSON(tracks_[i], track_depths[i]));
+        tracks.BuildJSONObjectArray();
+        json.AddObject(tracks);
     }
+    json.BuildJSONObject();
+    return json;
+}
+
+ActivitySummary ActivityEvent::Summary() const
+{
+    ActivitySummary summary;
+    summary.id = id_;
+    summary.frame_start = _start_frame;
+    summary.frame_end = _end_frame;
+
+    // The median is robust against the occasional bad stereo match.
+    summary.length_samples = lengths_.size();
+    if(!lengths_.empty()) summary.length_mm = Median(lengths_);
+    summary.depth_samples = depths_.size();
+
+    // Both cameras track the same fish, so the busier camera is the count.
+    size_t n_objects[2] = { 0, 0 };
+    for(auto& track : tracks_)
+    {
+        int camera = track.camera == 0 ? 0 : 1;
+        n_objects[camera]++;
+        for(auto& box : track.boxes)
+            summary.bounds[camera] = summary.bounds[camera].empty() ? box.second : (summary.bounds[camera] | box.second);
+    }
+    summary.n_objects = std::max(n_objects[0], n_objects[1]);
+    return summary;
 }
 
 bool ActivityEvent::IsActive() const
@@ -134,24 +219,165 @@ bool ActivityEvent::IsActive() const
     return (_start_frame != -1 && _end_frame == -1);
 }
 
+void ActivityEvent::BackdateStart(int frame)
+{
+    if(frame >= 0 && frame < _start_frame) _start_frame = frame;
+}
+
+void ActivityEvent::AddMeasurement(float length)
+{
+    lengths_.push_back(length);
+}
+
+void ActivityEvent::AddDepth(int frame, const cv::Rect& box, float depth)
+{
+    depths_.push_back(ObjectDepth{ frame, box, depth });
+}
+
+void ActivityEvent::AddSpeciesCandidate(const std::string& species)
+{
+    species_[species]++;
+}
+
+void ActivityEvent::AddTrack(const ObjectTrack& track)
+{
+    tracks_.push_back(track);
+}
+
+void ActivityEvent::AddDetection(const Detection& detection)
+{
+    detections_.push_back(detection);
+}
+
+void ActivityEvent::SetThumbnails(EventThumbnails thumbnails)
+{
+    thumbnails_ = std::move(thumbnails);
+}
+
+const EventThumbnails& ActivityEvent::GetThumbnails() const
+{
+    return thumbnails_;
+}
+
+void ActivityEvent::Merge(ActivityEvent&& later)
+{
+    _start_frame = std::min(_start_frame, later._start_frame);
+    _end_frame = later._end_frame;
+
+    lengths_.insert(lengths_.end(), later.lengths_.begin(), later.lengths_.end());
+    depths_.insert(depths_.end(), later.depths_.begin(), later.depths_.end());
+    std::move(later.tracks_.begin(), later.tracks_.end(), std::back_inserter(tracks_));
+    std::move(later.detections_.begin(), later.detections_.end(), std::back_inserter(detections_));
+    for(auto& species : later.species_)
+        species_[species.first] += species.second;
+
+    // The previews of the part with the larger object stand for both.
+    if(later.thumbnails_.box.area() > thumbnails_.box.area())
+        thumbnails_ = std::move(later.thumbnails_);
+
+    later = ActivityEvent(later.id_, -1, -1);
+}
+
+int ActivityEvent::GetId() const
+{
+    return id_;
+}
+
+void ActivityEvent::SetId(int id)
+{
+    id_ = id;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Helper Functions
-std::vector<std::string> SplitString(std::string& str, const char* delimiter)
+float Median(std::vector<float> values)
+{
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+JSON TrackToJSON(const ObjectTrack& track, const std::vector<float>& depths)
 {
-    std::vector<std::string> result;
-    size_t i = 0;
-    std::string temp = str;
+    // Boxes are written compactly as [frame, x, y, width, height].
+    std::string boxes = "[";
+    for(size_t i = 0; i < track.boxes.size(); i++)
+    {
+        const cv::Rect& box = track.boxes[i].second;
+        boxes += (i > 0 ? ",[" : "[") + std::to_string(track.boxes[i].first) + "," +
+                 std::to_string(box.x) + "," + std::to_string(box.y) + "," +
+                 std::to_string(box.width) + "," + std::to_string(box.height) + "]";
+    }
+    boxes += "]";
+
+    JSON json("Track_" + std::to_string(track.id));
+    json.AddKeyValue("camera", std::to_string(track.camera));
+    json.AddKeyValue("frame_start", std::to_string(track.frame_start));
+    json.AddKeyValue("frame_end", std::to_string(track.frame_end));
+    json.AddRawValue("boxes", boxes);
+
+    // The median is robust against the occasional bad disparity.
+    if(!depths.empty())
+    {
+        json.AddKeyValue("depth_mm", std::to_string(Median(depths)));
+        json.AddKeyValue("depth_samples", std::to_string(depths.size()));
+    }
+    json.BuildJSONObject();
+    return json;
+}
 
-    std::regex r("\\s+");
-    while ((i = temp.find(delimiter)) != std::string::npos)
+std::string DetectionsToJSON(const std::vector<Detection>& detections)
+{
+    // Detections are written compactly as [frame, camera, label, score, x, y, width, height].
+    std::string json = "[";
+    for(size_t i = 0; i < detections.size(); i++)
     {
-        if (i > str.length())
-            i = str.length() - 1;
-        result.push_back(regex_replace(temp.substr(0, i), r, ""));
-        temp.erase(0, i + 1);
+        const Detection& det = detections[i];
+        json += (i > 0 ? ",[" : "[") + std::to_string(det.frame) + "," + std::to_string(det.camera) + "," +
+                std::to_string(det.label) + "," + std::to_string(det.score) + "," +
+                std::to_string(det.box.x) + "," + std::to_string(det.box.y) + "," +
+                std::to_string(det.box.width) + "," + std::to_string(det.box.height) + "]";
     }
-    if(regex_replace(temp.substr(0, i), r, "") != "") 
-        result.push_back(regex_replace(temp.substr(0, i), r, ""));
+    return json + "]";
+}
 
-    return result;
-}
\ No newline at end of file
+std::string DepthsToJSON(const std::vector<ObjectDepth>& depths)
+{
+    // Depths are written compactly as [frame, x, y, width, height, depth].
+    std::string json = "[";
+    for(size_t i = 0; i < depths.size(); i++)
+    {
+        const ObjectDepth& depth = depths[i];
+        json += (i > 0 ? ",[" : "[") + std::to_string(depth.frame) + "," +
+                std::to_string(depth.box.x) + "," + std::to_string(depth.box.y) + "," +
+                std::to_string(depth.box.width) + "," + std::to_string(depth.box.height) + "," +
+                std::to_string(depth.depth_mm) + "]";
+    }
+    return json + "]";
+}
+
+JSON ThumbnailsToJSON(const EventThumbnails& thumbnails)
+{
+    std::string frames = "[";
+    for(size_t i = 0; i < thumbnails.strip_frames.size(); i++)
+        frames += (i > 0 ? "," : "") + std::to_string(thumbnails.strip_frames[i]);
+    frames += "]";
+
+    JSON json("thumbnails");
+    if(!thumbnails.strip_file.empty())
+    {
+        json.AddKeyValue("strip", thumbnails.strip_file);
+        json.AddRawValue("strip_frames", frames);
+    }
+    if(!thumbnails.keyframe_file.empty())
+    {
+        // The box is written compactly as [frame, camera, x, y, width, height].
+        const cv::Rect& box = thumbnails.box;
+        json.AddKeyValue("keyframe", thumbnails.keyframe_file);
+        json.AddRawValue("keyframe_box", "[" + std::to_string(thumbnails.keyframe_frame) + "," +
+                         std::to_string(thumbnails.keyframe_camera) + "," + std::to_string(box.x) + "," +
+                         std::to_string(box.y) + "," + std::to_string(box.width) + "," +
+                         std::to_string(box.height) + "]");
+    }
+    json.BuildJSONObject();
+    return json;
+}
@@ -0,0 +1,80 @@
+#include "includes/FileHash.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+// 64 bit FNV-1a parameters.
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME        1099511628211ULL
+
+// Bytes read from each end of a file for its fingerprint.
+#define FINGERPRINT_BYTES (1 << 20)
+
+uint64_t HashBytes(uint64_t hash, const char* bytes, size_t n);
+
+uint64_t HashFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()) return 0;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    std::vector<char> buffer(1 << 16);
+    while(file)
+    {
+        file.read(buffer.data(), buffer.size());
+        hash = HashBytes(hash, buffer.data(), (size_t)file.gcount());
+    }
+
+    return hash;
+}
+
+uint64_t FingerprintFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file.is_open()) return 0;
+
+    // The size covers edits in the middle which change the length.
+    uint64_t size = (uint64_t)file.tellg();
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for(int i = 0; i < 8; i++)
+    {
+        char byte = (char)(size >> (8 * i));
+        hash = HashBytes(hash, &byte, 1);
+    }
+
+    // Containers keep their headers and indexes at either end.
+    std::vector<char> buffer(FINGERPRINT_BYTES);
+    uint64_t tail = size > FINGERPRINT_BYTES ? size - FINGERPRINT_BYTES : 0;
+    for(uint64_t offset : { (uint64_t)0, tail })
+    {
+        file.clear();
+        file.seekg((std::streamoff)offset);
+        file.read(buffer.data(), buffer.size());
+        hash = HashBytes(hash, buffer.data(), (size_t)file.gcount());
+    }
+
+    return hash;
+}
+
+std::string HashToString(uint64_t hash)
+{
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)hash);
+    return std::string(buffer);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+uint64_t HashBytes(uint64_t hash, const char* bytes, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        hash ^= (unsigned char)bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
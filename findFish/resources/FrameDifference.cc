@@ -0,0 +1,33 @@
+#include "includes/FrameDifference.h"
+
+FrameDifference::FrameDifference(int threshold)
+    : _threshold{threshold}
+{
+}
+
+void FrameDifference::apply(cv::InputArray image, cv::OutputArray fgmask, double learningRate)
+{
+    cv::Mat frame = image.getMat(), gray;
+    if(frame.channels() == 3)
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    else
+        gray = frame.clone();
+
+    // The first frame has nothing to compare to, so nothing is moving yet.
+    if(_previous.empty() || _previous.size() != gray.size())
+        cv::Mat(gray.size(), CV_8UC1, cv::Scalar(0)).copyTo(fgmask);
+    else
+    {
+        cv::Mat diff;
+        cv::absdiff(gray, _previous, diff);
+        cv::threshold(diff, fgmask, _threshold, 255, cv::THRESH_BINARY);
+    }
+
+    if(learningRate != 0 || _previous.empty())
+        _previous = gray;
+}
+
+void FrameDifference::getBackgroundImage(cv::OutputArray backgroundImage) const
+{
+    _previous.copyTo(backgroundImage);
+}
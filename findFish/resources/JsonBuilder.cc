@@ -12,6 +12,7 @@ JSON::JSON(const JSON& j)
     this->_name = j._name;
     this->_json_string = j._json_string;
     this->_key_val_pairs = j._key_val_pairs;
+    this->_raw_keys = j._raw_keys;
 }
 
 JSON::~JSON()
@@ -47,6 +48,12 @@ void JSON::AddKeyValue(std::string Key, std::string Value)
     _key_val_pairs.insert(std::make_pair(Key, Value));
 }
 
+void JSON::AddRawValue(std::string Key, std::string Value)
+{
+    _key_val_pairs.insert(std::make_pair(Key, Value));
+    _raw_keys.insert(Key);
+}
+
 void JSON::AddObject(JSON& Object)
 {
     if(Object.GetJSON() != "{}")
@@ -70,13 +77,13 @@ void JSON::BuildJSONObject()
         
         char* err;
         std::strtod(e.second.c_str(), &err);
-        _json_string += *err == '\0' ? e.second : "\"" + e.second + "\"";
+        _json_string += *err == '\0' || _raw_keys.count(e.first) ? e.second : "\"" + e.second + "\"";
 
         if(it != _key_val_pairs.end()) _json_string += ",";
     }
 
     auto jt = _subobjects.begin();
-    if(!_key_val_pairs.empty() && it != _key_val_pairs.end()) _json_string += ",";
+    if(!_key_val_pairs.empty() && !_subobjects.empty()) _json_string += ",";
     for(auto e : _subobjects)
     {
         ++jt;
@@ -98,13 +105,13 @@ void JSON::BuildJSONObjectArray()
         
         char* err;
         std::strtod(e.second.c_str(), &err);
-        _json_string += *err == '\0' ? e.second : "\"" + e.second + "\"";
+        _json_string += *err == '\0' || _raw_keys.count(e.first) ? e.second : "\"" + e.second + "\"";
         _json_string += "}";
         if(it != _key_val_pairs.end()) _json_string += ",";
     }
 
     auto jt = _subobjects.begin();
-    if(!_key_val_pairs.empty() && it != _key_val_pairs.end()) _json_string += ",";
+    if(!_key_val_pairs.empty() && !_subobjects.empty()) _json_string += ",";
     for(auto e : _subobjects)
     {
         ++jt;
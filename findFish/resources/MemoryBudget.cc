@@ -0,0 +1,153 @@
+#include "includes/MemoryBudget.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+size_t ReadStatus(const char* key);
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory Budget
+MemoryBudget::MemoryBudget(MemoryBudget::Settings settings)
+    : Config{settings}
+{
+}
+
+MemoryPlan MemoryBudget::Plan(cv::Size frame_size, int max_depth, int max_threads, size_t in_use) const
+{
+    MemoryPlan plan;
+    max_depth = std::max(max_depth, 0);
+    max_threads = std::max(max_threads, 1);
+
+    if(!IsLimited())
+    {
+        plan.queue_depth = max_depth;
+        plan.pool_frames = 2 * (max_depth + 2);
+        plan.threads = max_threads;
+        return plan;
+    }
+
+    // Decoded frames are 8 bit BGR.
+    size_t frame = std::max((size_t)frame_size.area() * 3, (size_t)1);
+    size_t budget = Config.BudgetMB << 20;
+    size_t available = budget > in_use ? budget - in_use : 0;
+    size_t working = (Config.WorkingFrames + Config.ThreadFrames) * frame;
+    if(available < working)
+    {
+        plan.pool_frames = 4;
+        plan.fits = false;
+        return plan;
+    }
+
+    // Workers come first, as running short of them only slows processing,
+    // while every frame pair held costs two frames.
+    size_t spare = available - working;
+    size_t per_thread = std::max(Config.ThreadFrames, 1) * frame;
+    plan.threads = (int)std::min((size_t)max_threads, 1 + spare / per_thread);
+    spare -= (plan.threads - 1) * per_thread;
+
+    plan.queue_depth = (int)std::min((size_t)max_depth, spare / (2 * frame));
+    plan.pool_frames = 2 * (plan.queue_depth + 2);
+    return plan;
+}
+
+bool MemoryBudget::Enforce(MemoryPlan& plan, size_t rss) const
+{
+    if(!IsLimited() || rss <= (Config.BudgetMB << 20))
+        return false;
+
+    MemoryPlan shrunk = plan;
+    shrunk.queue_depth /= 2;
+    shrunk.pool_frames = 2 * (shrunk.queue_depth + 2);
+    shrunk.threads = std::max(plan.threads / 2, 1);
+    if(shrunk.queue_depth == plan.queue_depth && shrunk.threads == plan.threads)
+        return false;
+
+    plan = shrunk;
+    return true;
+}
+
+bool MemoryBudget::IsLimited() const
+{
+    return Config.BudgetMB > 0;
+}
+
+size_t MemoryBudget::ResidentBytes()
+{
+    return ReadStatus("VmRSS:");
+}
+
+size_t MemoryBudget::PeakResidentBytes()
+{
+    return ReadStatus("VmHWM:");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Frame Pool
+FramePool::FramePool(size_t capacity)
+    : _shared{std::make_shared<Shared>()}
+{
+    _shared->capacity = capacity;
+}
+
+std::shared_ptr<cv::Mat> FramePool::Acquire()
+{
+    cv::Mat* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_shared->mutex);
+        if(!_shared->frames.empty())
+        {
+            frame = new cv::Mat(std::move(_shared->frames.back()));
+            _shared->frames.pop_back();
+        }
+    }
+    if(!frame) frame = new cv::Mat();
+
+    // Frames whose image is still shared, e.g. by the tracker, are freed
+    // instead, as reading into them would overwrite it.
+    std::weak_ptr<Shared> pool = _shared;
+    return std::shared_ptr<cv::Mat>(frame, [pool](cv::Mat* frame)
+    {
+        auto shared = pool.lock();
+        if(shared && !frame->empty() && frame->u && frame->u->refcount == 1)
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            if(shared->frames.size() < shared->capacity)
+                shared->frames.push_back(std::move(*frame));
+        }
+        delete frame;
+    });
+}
+
+void FramePool::SetCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(_shared->mutex);
+    _shared->capacity = capacity;
+    if(_shared->frames.size() > capacity)
+        _shared->frames.resize(capacity);
+}
+
+size_t FramePool::Available() const
+{
+    std::lock_guard<std::mutex> lock(_shared->mutex);
+    return _shared->frames.size();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+size_t ReadStatus(const char* key)
+{
+    // Lines look like "VmRSS:	  123456 kB".
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t length = std::strlen(key);
+    while(std::getline(status, line))
+        if(line.compare(0, length, key) == 0)
+            return (size_t)std::strtoull(line.c_str() + length, nullptr, 10) << 10;
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "includes/Metrics.h"
+#include "includes/MemoryBudget.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::string JoinNumbers(const std::vector<double>& values);
+
+///////////////////////////////////////////////////////////////////////////////
+// Histogram
+void Metrics::Histogram::Add(double ms)
+{
+    const auto& bounds = BucketBounds();
+    if(buckets.empty())
+        buckets.resize(bounds.size() + 1, 0);
+
+    size_t bucket = std::upper_bound(bounds.begin(), bounds.end(), ms) - bounds.begin();
+    buckets[bucket]++;
+
+    min_ms = count == 0 ? ms : std::min(min_ms, ms);
+    max_ms = count == 0 ? ms : std::max(max_ms, ms);
+    total_ms += ms;
+    count++;
+}
+
+double Metrics::Histogram::Mean() const
+{
+    return count > 0 ? total_ms / count : 0.0;
+}
+
+double Metrics::Histogram::Percentile(double p) const
+{
+    const auto& bounds = BucketBounds();
+    long rank = std::max(1L, (long)(p * count + 0.5)), seen = 0;
+    for(size_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if(seen >= rank)
+            return i < bounds.size() ? std::min(bounds[i], max_ms) : max_ms;
+    }
+    return max_ms;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Scoped Timer
+Metrics::ScopedTimer::ScopedTimer(Metrics* metrics, const char* stage)
+    : _metrics{metrics}, _stage{stage}, _start{cv::getTickCount()}
+{
+}
+
+Metrics::ScopedTimer::~ScopedTimer()
+{
+    if(_metrics)
+    {
+        _metrics->AddSample(_stage, (double)(cv::getTickCount() - _start) * 1000.0 / cv::getTickFrequency());
+        if(_metrics->IsSamplingMemory())
+            _metrics->AddMemorySample(_stage, MemoryBudget::ResidentBytes());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Metrics
+void Metrics::AddSample(const std::string& stage, double ms)
+{
+    _stages[stage].Add(ms);
+}
+
+void Metrics::AddMemorySample(const std::string& stage, size_t bytes)
+{
+    auto& hist = _stages[stage];
+    hist.process_rss = std::max(hist.process_rss, bytes);
+}
+
+void Metrics::SetMemorySampling(bool bSample)
+{
+    _sample_memory = bSample;
+}
+
+bool Metrics::IsSamplingMemory() const
+{
+    return _sample_memory;
+}
+
+void Metrics::Increment(const std::string& counter, long n)
+{
+    _counters[counter] += n;
+}
+
+long Metrics::GetCounter(const std::string& counter) const
+{
+    auto it = _counters.find(counter);
+    return it != _counters.end() ? it->second : 0;
+}
+
+void Metrics::SetGauge(const std::string& gauge, double value)
+{
+    _gauges[gauge] = value;
+}
+
+double Metrics::GetGauge(const std::string& gauge) const
+{
+    auto it = _gauges.find(gauge);
+    return it != _gauges.end() ? it->second : 0.0;
+}
+
+const Metrics::Histogram* Metrics::GetStage(const std::string& stage) const
+{
+    auto it = _stages.find(stage);
+    return it != _stages.end() ? &it->second : nullptr;
+}
+
+JSON Metrics::ToJSON() const
+{
+    JSON stages("stages_ms");
+    for(auto& stage : _stages)
+    {
+        const Histogram& hist = stage.second;
+        JSON json(stage.first);
+        json.AddKeyValue("count", std::to_string(hist.count));
+        json.AddKeyValue("total", std::to_string(hist.total_ms));
+        json.AddKeyValue("mean", std::to_string(hist.Mean()));
+        json.AddKeyValue("min", std::to_string(hist.min_ms));
+        json.AddKeyValue("max", std::to_string(hist.max_ms));
+        json.AddKeyValue("p50", std::to_string(hist.Percentile(0.5)));
+        json.AddKeyValue("p95", std::to_string(hist.Percentile(0.95)));
+        json.AddRawValue("histogram", JoinNumbers(std::vector<double>(hist.buckets.begin(), hist.buckets.end())));
+        if(hist.process_rss > 0)
+            json.AddKeyValue("process_rss_mb", std::to_string((double)hist.process_rss / (1 << 20)));
+        json.BuildJSONObject();
+        stages.AddObject(json);
+    }
+    stages.BuildJSONObject();
+
+    std::map<std::string, std::string> counters;
+    for(auto& counter : _counters)
+        counters.insert(std::make_pair(counter.first, std::to_string(counter.second)));
+
+    // The subobjects must be added before the summary is copied anywhere.
+    JSON summary("Metrics");
+    summary.AddRawValue("buckets_ms", JoinNumbers(BucketBounds()));
+    summary.AddObject(JSON("counters", counters));
+    if(!_gauges.empty())
+    {
+        std::map<std::string, std::string> gauges;
+        for(auto& gauge : _gauges)
+            gauges.insert(std::make_pair(gauge.first, std::to_string(gauge.second)));
+        summary.AddObject(JSON("gauges", gauges));
+    }
+    summary.AddObject(stages);
+    summary.BuildJSONObject();
+    return summary;
+}
+
+void Metrics::Write(const std::string& file) const
+{
+    std::ofstream out(file);
+    if(!out.is_open())
+        throw std::runtime_error("Could not write metrics to \"" + file + "\"!");
+    out << ToJSON().GetJSON();
+}
+
+void Metrics::Stream(std::ostream& out) const
+{
+    out << ToJSON().GetJSON() << std::endl;
+}
+
+const std::vector<double>& Metrics::BucketBounds()
+{
+    static const std::vector<double> bounds = { 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000 };
+    return bounds;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+std::string JoinNumbers(const std::vector<double>& values)
+{
+    std::ostringstream json;
+    json << "[";
+    for(size_t i = 0; i < values.size(); i++)
+        json << (i > 0 ? "," : "") << values[i];
+    json << "]";
+    return json.str();
+}
@@ -0,0 +1,166 @@
+#include "includes/ObjectTracker.h"
+
+#include <algorithm>
+#include <tuple>
+
+// The filter state is the box centre, its size, and the centre's velocity.
+#define STATE_SIZE 6
+#define MEASUREMENT_SIZE 4
+
+float IoU(const cv::Rect2f&, const cv::Rect2f&);
+cv::Mat BoxToMeasurement(const cv::Rect&);
+cv::Rect2f StateToBox(const cv::Mat&);
+
+ObjectTracker::ObjectTracker()
+    : ObjectTracker(Settings())
+{
+}
+
+ObjectTracker::ObjectTracker(Settings settings, int camera)
+    : Config{settings}, _camera{camera}, _next_id{1}
+{
+}
+
+void ObjectTracker::Update(const std::vector<cv::Rect>& boxes, int frame)
+{
+    // Predict where every track should be in this frame.
+    for(auto& state : _tracks)
+    {
+        float dt = (float)(frame - state.predicted_frame);
+        state.filter.transitionMatrix.at<float>(0, 4) = dt;
+        state.filter.transitionMatrix.at<float>(1, 5) = dt;
+        state.prediction = StateToBox(state.filter.predict());
+        state.predicted_frame = frame;
+    }
+
+    // Greedily match the most overlapping prediction and box pairs first.
+    std::vector<std::tuple<float, size_t, size_t>> pairs;
+    for(size_t t = 0; t < _tracks.size(); t++)
+        for(size_t b = 0; b < boxes.size(); b++)
+        {
+            float overlap = IoU(_tracks[t].prediction, cv::Rect2f(boxes[b]));
+            if(overlap >= Config.MinIoU)
+                pairs.push_back(std::make_tuple(overlap, t, b));
+        }
+    std::sort(pairs.begin(), pairs.end(), [](const std::tuple<float, size_t, size_t>& a,
+                                             const std::tuple<float, size_t, size_t>& b)
+                                          { return std::get<0>(a) > std::get<0>(b); });
+
+    std::vector<bool> track_matched(_tracks.size(), false), box_matched(boxes.size(), false);
+    for(auto& pair : pairs)
+    {
+        size_t t = std::get<1>(pair), b = std::get<2>(pair);
+        if(track_matched[t] || box_matched[b]) continue;
+        track_matched[t] = box_matched[b] = true;
+
+        TrackState& state = _tracks[t];
+        state.filter.correct(BoxToMeasurement(boxes[b]));
+        state.track.boxes.push_back(std::make_pair(frame, boxes[b]));
+        state.track.frame_end = frame;
+        state.hits++;
+        state.missed = 0;
+    }
+
+    // Finish the tracks which have been lost for too long.
+    size_t kept = 0;
+    for(size_t t = 0; t < _tracks.size(); t++)
+    {
+        if(!track_matched[t] && ++_tracks[t].missed > Config.MaxMissed)
+        {
+            FinishTrack(_tracks[t]);
+            continue;
+        }
+        if(kept != t) _tracks[kept] = std::move(_tracks[t]);
+        kept++;
+    }
+    _tracks.resize(kept);
+
+    for(size_t b = 0; b < boxes.size(); b++)
+        if(!box_matched[b])
+            StartTrack(boxes[b], frame);
+}
+
+std::vector<ObjectTrack> ObjectTracker::Flush()
+{
+    for(auto& state : _tracks)
+        FinishTrack(state);
+    _tracks.clear();
+
+    std::sort(_finished.begin(), _finished.end(), [](const ObjectTrack& a, const ObjectTrack& b)
+                                                  { return a.frame_start != b.frame_start ?
+                                                           a.frame_start < b.frame_start : a.id < b.id; });
+
+    std::vector<ObjectTrack> finished;
+    finished.swap(_finished);
+    return finished;
+}
+
+size_t ObjectTracker::ActiveTracks() const
+{
+    return _tracks.size();
+}
+
+void ObjectTracker::StartTrack(const cv::Rect& box, int frame)
+{
+    TrackState state;
+    state.track.id = _next_id++;
+    state.track.camera = _camera;
+    state.track.frame_start = frame;
+    state.track.frame_end = frame;
+    state.track.boxes.push_back(std::make_pair(frame, box));
+    state.prediction = cv::Rect2f(box);
+    state.predicted_frame = frame;
+    state.hits = 1;
+    state.missed = 0;
+
+    // Constant velocity model, where only the box itself is measured.
+    cv::KalmanFilter& filter = state.filter;
+    filter.init(STATE_SIZE, MEASUREMENT_SIZE, 0, CV_32F);
+    cv::setIdentity(filter.transitionMatrix);
+    cv::setIdentity(filter.measurementMatrix);
+    cv::setIdentity(filter.processNoiseCov, cv::Scalar::all(1));
+    cv::setIdentity(filter.measurementNoiseCov, cv::Scalar::all(10));
+    cv::setIdentity(filter.errorCovPost, cv::Scalar::all(100));
+
+    // The object starts out standing still.
+    cv::Mat measurement = BoxToMeasurement(box);
+    for(int i = 0; i < MEASUREMENT_SIZE; i++)
+        filter.statePost.at<float>(i) = measurement.at<float>(i);
+
+    _tracks.push_back(std::move(state));
+}
+
+void ObjectTracker::FinishTrack(TrackState& state)
+{
+    // Objects seen only briefly are most likely noise in the mask.
+    if(state.hits >= Config.MinHits)
+        _finished.push_back(std::move(state.track));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+float IoU(const cv::Rect2f& a, const cv::Rect2f& b)
+{
+    float intersection = (a & b).area();
+    float combined = a.area() + b.area() - intersection;
+    return combined > 0.f ? intersection / combined : 0.f;
+}
+
+cv::Mat BoxToMeasurement(const cv::Rect& box)
+{
+    cv::Mat measurement(MEASUREMENT_SIZE, 1, CV_32F);
+    measurement.at<float>(0) = box.x + box.width / 2.f;
+    measurement.at<float>(1) = box.y + box.height / 2.f;
+    measurement.at<float>(2) = (float)box.width;
+    measurement.at<float>(3) = (float)box.height;
+    return measurement;
+}
+
+cv::Rect2f StateToBox(const cv::Mat& state)
+{
+    float w = std::max(state.at<float>(2), 1.f), h = std::max(state.at<float>(3), 1.f);
+    return cv::Rect2f(state.at<float>(0) - w / 2.f, state.at<float>(1) - h / 2.f, w, h);
+}
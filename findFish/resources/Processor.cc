@@ -3,13 +3,24 @@
 #include "includes/EventDetector.h"
 #include "includes/Calibration.h"
 #include "includes/Tracker.h"
+#include "includes/StereoMeasure.h"
+#include "includes/Disparity.h"
+#include "includes/Metrics.h"
+#include "includes/SyncEngine.h"
+#include "includes/FileHash.h"
+#include "includes/Thumbnails.h"
+#include "includes/SegmentWriter.h"
+#include "includes/MemoryBudget.h"
 
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <time.h>
+#include <cmath>
 #include <stdexcept>
 
+#include <opencv2/core/utils/filesystem.hpp>
+
 cv::Mat ConcatenateMatrices(cv::Mat&, cv::Mat&);
 void ReadVectorOfVector(cv::FileStorage&, std::string, std::vector<std::vector<cv::Point2f>>&);
 
@@ -24,7 +35,12 @@ Processor::Processor()
 }
 
 Processor::Processor(std::string left_file, std::string right_file)
-    : Success{false}
+    : Processor(left_file, right_file, Settings())
+{
+}
+
+Processor::Processor(std::string left_file, std::string right_file, Settings settings)
+    : Success{false}, Config{settings}
 {
     if(left_file != "" && right_file != "")
     {
@@ -37,9 +53,23 @@ Processor::Processor(std::string left_file, std::string right_file)
         Tracker::Settings t_conf;
         t_conf.bDrawContours = false;
         t_conf.MinThreshold = 200;
+        t_conf.Subtractor = Tracker::GetBackend(Config.Subtractor);
+        t_conf.EnterFrames = Config.EventEnterFrames;
+        t_conf.ExitFrames = Config.EventExitFrames;
+        t_conf.MergeGap = Config.EventMergeGap;
+        t_conf.MinEventFrames = Config.MinEventFrames;
+        t_conf.bUseDnn = !Config.DetectorModel.empty();
+        t_conf.Dnn.Model = Config.DetectorModel;
+        t_conf.Dnn.ConfigFile = Config.DetectorConfig;
         _tracker = std::make_unique<Tracker>(t_conf);
 
+        _metrics = std::make_shared<Metrics>();
+        _tracker->SetMetrics(_metrics);
+
         _detected_events = std::make_shared<JSON>("DetectedEvents");
+
+        if(Config.bSaveThumbnails)
+            _thumbnails = std::make_unique<ThumbnailBuilder>(ThumbnailBuilder::Settings());
     }
 
     Calibration::Input input;
@@ -47,6 +77,23 @@ Processor::Processor(std::string left_file, std::string right_file)
 
     _calib = std::make_shared<Calibration>(input, CalibrationType::STEREO, "stereo_calibration.yaml");
     _calib->ReadCalibration();
+
+    if(Config.bMeasureObjects)
+    {
+        if(_calib->IsStereoCalibrated())
+        {
+            _measure = std::make_unique<StereoMeasure>(_calib, StereoMeasure::Settings());
+
+            if(Config.bEstimateDepth)
+            {
+                Disparity::Settings d_conf;
+                d_conf.bUseWLS = Config.bFilterDepth;
+                _disparity = std::make_unique<Disparity>(_calib, d_conf);
+            }
+        }
+        else
+            std::cout << " !> No stereo calibration found, objects will not be measured.\n";
+    }
 }
 
 Processor::~Processor()
@@ -73,43 +120,150 @@ void Processor::ProcessVideos()
             if (!SyncVideos())
                 throw std::runtime_error("Videos did not sync. Either they are "
                                         "missing QR code(s), or none were detected.");
-
-            // Create a writer for the new combined video.
-            cv::VideoWriter writer(
-                file_name,
-                _videos[0]->FOURCC,
-                _videos[0]->FPS,
-                cv::Size(_videos[0]->Width + _videos[1]->Width,
-                        std::max(_videos[0]->Height, _videos[1]->Height)),
-                true);
+            _detected_events->AddObject(_sync->ToJSON());
+
+            // Create a writer for the new combined video, and one for its
+            // proxy, which takes its place for reviewers when enabled.
+            cv::Size canvas(_videos[0]->Width + _videos[1]->Width,
+                            std::max(_videos[0]->Height, _videos[1]->Height));
+            cv::Size proxy_size = GetProxySize(canvas, Config.ProxyWidth);
+            std::string archive_name = file_name;
+            std::unique_ptr<cv::VideoWriter> proxy;
+            std::unique_ptr<SegmentWriter> segments;
+            if(!proxy_size.empty())
+            {
+                proxy = std::make_unique<cv::VideoWriter>(file_name, _videos[0]->FOURCC, _videos[0]->FPS,
+                                                          proxy_size, true);
+                if(Config.SegmentSeconds > 0)
+                {
+                    SegmentWriter::Settings w_conf;
+                    w_conf.SegmentFrames = std::max((int)std::lround(Config.SegmentSeconds * _videos[0]->FPS), 1);
+                    segments = std::make_unique<SegmentWriter>(
+                        cv::utils::fs::join(Config.SegmentDir, _videos[0]->FileName), _videos[0]->FileName,
+                        _videos[0]->FOURCC, _videos[0]->FPS, canvas, w_conf);
+                }
+                else
+                {
+                    cv::utils::fs::createDirectories(Config.ArchiveDir);
+                    archive_name = cv::utils::fs::join(Config.ArchiveDir, _videos[0]->FileName + ".mp4");
+                }
+            }
+            cv::VideoWriter writer;
+            if(!segments)
+                writer.open(archive_name, _videos[0]->FOURCC, _videos[0]->FPS, canvas, true);
+
+            // Size the frames held while idle, the frame pool and the workers
+            // to the memory left in the budget.
+            MemoryBudget::Settings m_conf;
+            m_conf.BudgetMB = Config.MemoryBudgetMB;
+            MemoryBudget budget(m_conf);
+            MemoryPlan plan = budget.Plan(cv::Size(std::max(_videos[0]->Width, _videos[1]->Width),
+                                                   std::max(_videos[0]->Height, _videos[1]->Height)),
+                                          Config.IdleStride - 1, cv::getNumberOfCPUs(),
+                                          MemoryBudget::ResidentBytes());
+            if(!plan.fits)
+                std::cout << " !> Memory budget of " << Config.MemoryBudgetMB << " MB is too small, "
+                          << "processing with as little memory as possible.\n";
+            if(budget.IsLimited())
+                cv::setNumThreads(plan.threads);
+
+            auto pool = std::make_shared<FramePool>(plan.pool_frames);
+            for(int i = 0; i < 2; i++)
+                _videos[i]->SetFramePool(pool);
 
             int frame_num = 0;
             while (!_videos[0]->Ended() && !_videos[1]->Ended())
             {
                 std::shared_ptr<cv::Mat> frames[2];
+                std::vector<cv::Rect> boxes[2];
                 for(int i = 0; i < 2; i++)
+                {
+                    Metrics::ScopedTimer timer(_metrics.get(), "decode");
                     _videos[i]->Read();
+                }
                 
                 if(_videos[0]->Get() && _videos[1]->Get())
                 {
+                    bool bSampleMemory = frame_num % m_conf.SampleInterval == 0;
+                    _metrics->SetMemorySampling(bSampleMemory);
+                    if(bSampleMemory && budget.Enforce(plan, MemoryBudget::ResidentBytes()))
+                    {
+                        pool->SetCapacity(plan.pool_frames);
+                        cv::setNumThreads(plan.threads);
+                        _metrics->Increment("memory_throttled");
+                    }
+
+                    bool bTrack = _tracker->IsActive() || Config.IdleStride <= 1 ||
+                                  frame_num % Config.IdleStride == 0 ||
+                                  _tracker->GetSkippedCount() >= (size_t)plan.queue_depth;
                     for(int i = 0; i < 2; i++)
                     {
-                        // Undistort the frames using camera calibration data.
-                        frames[i] = _videos[i]->Get();
-                        UndistortImage(*frames[i], 0);
+                        // Undistort the frames using camera calibration data,
+                        // into frames from the pool.
+                        frames[i] = pool->Acquire();
+                        {
+                            Metrics::ScopedTimer timer(_metrics.get(), "undistort");
+                            UndistortImage(*_videos[i]->Get(), *frames[i], i);
+                        }
 
                         // Run the tracker on the undistorted frames.
-                        _tracker->CreateMask(*frames[i]);
+                        if(!bTrack) continue;
+                        _tracker->CreateMask(*frames[i], i);
+                        if(_measure || _thumbnails) boxes[i] = _tracker->GetBoundingBoxes(i);
+                    }
+
+                    if(bTrack)
+                    {
+                        bool bWasActive = _tracker->IsActive();
                         _tracker->CheckForActivity(frame_num);
+
+                        if(_thumbnails)
+                        {
+                            Metrics::ScopedTimer timer(_metrics.get(), "thumbnails");
+                            UpdateThumbnails(bWasActive, frame_num, frames, boxes);
+                        }
+
+                        if(_measure)
+                        {
+                            Metrics::ScopedTimer timer(_metrics.get(), "measure");
+                            MeasureObjects(frame_num, frames, boxes);
+                        }
+                        _metrics->Increment("frames_tracked");
                     }
+                    // Frames skipped while idle are kept by the tracker, in
+                    // case an event started somewhere among them, or until
+                    // the budget allows no more.
+                    else _tracker->SkipFrame(Tracker::SkippedFrame{ frame_num, { frames[0], frames[1] } });
 
                     // Write the concatenated undistorted frames.
-                    cv::Mat res = ConcatenateMatrices(*frames[0], *frames[1]);
-                    writer << res;
+                    cv::Mat res;
+                    {
+                        Metrics::ScopedTimer timer(_metrics.get(), "concatenate");
+                        res = ConcatenateMatrices(*frames[0], *frames[1]);
+                    }
+                    {
+                        Metrics::ScopedTimer timer(_metrics.get(), "encode");
+                        if(segments) segments->Write(res);
+                        else writer << res;
+                    }
+                    if(proxy)
+                    {
+                        Metrics::ScopedTimer timer(_metrics.get(), "proxy");
+                        cv::Mat small;
+                        cv::resize(res, small, proxy_size, 0, 0, cv::INTER_AREA);
+                        *proxy << small;
+                    }
+                    _metrics->Increment("frames");
                     frame_num++;
+
+                    if(Config.MetricsStreamInterval > 0 && frame_num % Config.MetricsStreamInterval == 0)
+                        _metrics->Stream(std::cout);
                 }
+                else _metrics->Increment("frames_empty");
             }
 
+            if(segments) segments->Close();
+            _metrics->SetMemorySampling(false);
             cv::destroyAllWindows();
             
             std::cout << "=== Finished Concatenating ===\n";
@@ -117,6 +271,23 @@ void Processor::ProcessVideos()
 
             AssembleEvents(frame_num);
 
+            _metrics->Increment("frames_dropped", _videos[0]->Dropped + _videos[1]->Dropped);
+            _metrics->Increment("events", (long)_tracker->ActivityRange.size());
+            _metrics->SetGauge("process_rss_peak_mb", (double)MemoryBudget::PeakResidentBytes() / (1 << 20));
+            if(!Config.MetricsDir.empty())
+            {
+                cv::utils::fs::createDirectories(Config.MetricsDir);
+                _metrics->Write(cv::utils::fs::join(Config.MetricsDir, "ME_" + _videos[0]->FileName + ".json"));
+            }
+
+            if(auto detector = _tracker->GetDetector())
+            {
+                auto& timings = detector->GetTimings();
+                std::cout << "=== Detector: " << timings.regions << " regions in " << timings.batches << " batches, "
+                          << timings.preprocess_ms << " ms preprocess, " << timings.forward_ms << " ms forward, "
+                          << timings.postprocess_ms << " ms postprocess ===\n";
+            }
+
             // Construct the JSON object array of all events detected.
             _detected_events->BuildJSONObjectArray();
 
@@ -161,45 +332,152 @@ void Processor::TriangulatePoints(std::string points_file, std::string calib_fil
     }
 }
 
-void Processor::UndistortImage(cv::Mat& frame, int index) const
+cv::Size Processor::GetProxySize(cv::Size canvas, int width)
 {
-    _calib->UndistortImage(frame, index);
+    width -= width % 2;
+    if(width <= 0 || width >= canvas.width || canvas.height <= 0)
+        return cv::Size();
+
+    int height = (int)std::lround((double)canvas.height * width / canvas.width);
+    return cv::Size(width, std::max(height - height % 2, 2));
+}
+
+void Processor::UndistortImage(const cv::Mat& frame, cv::Mat& undistorted, int index) const
+{
+    _calib->UndistortImage(frame, undistorted, index);
 }
 
 void Processor::AssembleEvents(int& last_frame) const
 {
-    for(auto event : _tracker->ActivityRange)
+    // Lets the tracker finish the tracks of an event still open at the end.
+    if(_thumbnails && _thumbnails->IsOpen() && _tracker->IsActive())
+        FinishThumbnails(_tracker->ActivityRange.back());
+    _tracker->EndActivity(last_frame);
+
+    for(auto& event : _tracker->ActivityRange)
+    {
+        if(event.IsActive())
+            event.EndEvent(last_frame);
+
+        // Thumbnails are named after their event once the events are merged
+        // and numbered.
+        if(_thumbnails)
+            try
+            {
+                auto thumbnails = event.GetThumbnails();
+                _thumbnails->Rename(thumbnails, cv::utils::fs::join(Config.ThumbnailDir,
+                                    _videos[0]->FileName + "_" + std::to_string(event.GetId())));
+                event.SetThumbnails(std::move(thumbnails));
+            }
+            catch(const std::exception& e)
+            {
+                std::cerr << " !> " << e.what() << '\n';
+            }
+        _detected_events->AddObject(event.GetAsJSON());
+    }
+
+    // Those of events which were dropped, or merged into another, are gone.
+    if(_thumbnails)
+        _thumbnails->RemoveUnused();
+}
+
+void Processor::MeasureObjects(int frame_num, std::shared_ptr<cv::Mat> frames[2], const std::vector<cv::Rect> boxes[2]) const
+{
+    if(_tracker->ActivityRange.empty() || !_tracker->ActivityRange.back().IsActive())
+        return;
+
+    auto& event = _tracker->ActivityRange.back();
+    for(auto& measurement : _measure->MeasureObjects(boxes[0], boxes[1]))
+    {
+        event.AddMeasurement(measurement.length);
+
+        if(_disparity)
+        {
+            float depth = _disparity->EstimateDepth(*frames[0], *frames[1], measurement.left_box, measurement.right_box);
+            if(depth > 0.f) event.AddDepth(frame_num, boxes[0][measurement.left_index], depth);
+        }
+    }
+}
+
+void Processor::UpdateThumbnails(bool bWasActive, int frame_num, std::shared_ptr<cv::Mat> frames[2],
+                                 const std::vector<cv::Rect> boxes[2]) const
+{
+    if(bWasActive && !_tracker->IsActive() && _thumbnails->IsOpen())
+        FinishThumbnails(_tracker->ActivityRange.back());
+
+    if(_tracker->IsActive())
+    {
+        if(!_thumbnails->IsOpen())
+            _thumbnails->Start(_tracker->ActivityRange.back().GetRange().first);
+
+        cv::Mat images[2] = { *frames[0], *frames[1] };
+        _thumbnails->Add(frame_num, images, boxes);
+    }
+}
+
+void Processor::FinishThumbnails(ActivityEvent& event) const
+{
+    auto thumbnails = _thumbnails->Finish();
+    try
     {
-        if(event->IsActive())
-            event->EndEvent(last_frame);
-        _detected_events->AddObject(event->GetAsJSON());
+        cv::utils::fs::createDirectories(Config.ThumbnailDir);
+        _thumbnails->Write(thumbnails, cv::utils::fs::join(Config.ThumbnailDir,
+                           _videos[0]->FileName + "_start_" + std::to_string(event.GetRange().first)));
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << " !> " << e.what() << '\n';
     }
+    event.SetThumbnails(std::move(thumbnails));
 }
 
-bool Processor::SyncVideos() const
+bool Processor::SyncVideos()
 {
-    for(int i = 0 ; i < 2; i++)
     {
-        QREvent detect_QR;
-        while(true)
+        Metrics::ScopedTimer timer(_metrics.get(), "sync");
+        SyncEngine::Settings s_conf;
+        s_conf.MaxSearchFrames = Config.SyncSearchFrames;
+        s_conf.bRefineBrightness = Config.bRefineSync;
+
+        // Fingerprints of 0 mean a video could not be read, which the search
+        // reports on its own.
+        uint64_t keys[2] = { 0, 0 };
+        std::unique_ptr<SyncCache> cache;
+        if(!Config.SyncCacheFile.empty())
         {
-            if(!detect_QR.DetectedQR())
+            for(int i = 0; i < 2; i++)
+                keys[i] = FingerprintFile(_videos[i]->GetPath());
+            if(keys[0] != 0 && keys[1] != 0)
+                cache = std::make_unique<SyncCache>(Config.SyncCacheFile, s_conf);
+        }
+
+        _sync = std::make_unique<SyncResult>();
+        if(cache && cache->Find(keys[0], keys[1], *_sync))
+            _metrics->Increment("sync_cached");
+        else
+        {
+            SyncEngine engine(s_conf);
+            engine.SetMetrics(_metrics);
+            *_sync = engine.Sync(_videos[0]->GetPath(), _videos[1]->GetPath());
+            if(cache && _sync->found)
             {
-                _videos[i]->Read();
-                if(_videos[i]->Get())
-                    detect_QR.CheckFrame(*_videos[i]->Get(), _videos[i]->Frame);
+                cache->Store(keys[0], keys[1], *_sync);
+                cache->Write();
             }
-            else break;
         }
-        if(!detect_QR.DetectedQR()) return false;
     }
-    std::cout << " > Synced videos\n";
+    if(!_sync->found) return false;
+
+    for(int i = 0; i < 2; i++)
+        _videos[i]->Seek(_sync->start[i]);
+
+    std::cout << " > Synced videos, right is " << _sync->offset + _sync->refinement << " frames after left\n";
     return true;
 }
 
 
 Video::Video(std::string file)
-    : FileName{""}, Frame{0}, TotalFrames{0}, _filepath{file}
+    : FileName{""}, Frame{0}, TotalFrames{0}, Dropped{0}, _filepath{file}
 {
     try
     {
@@ -234,23 +512,48 @@ void Video::Read()
     {
         if(Frame <= TotalFrames)
         {
-            cv::Mat frame;
+            auto frame = _pool ? _pool->Acquire() : std::make_shared<cv::Mat>();
             if (_vid_cap->isOpened()) 
-                _vid_cap->read(frame);
+                _vid_cap->read(*frame);
             
-            if(frame.empty())
+            if(frame->empty())
             {
+                Dropped++;
                 _mutex.unlock();
                 Read();
             }
             
-            _frame = std::make_shared<cv::Mat>(frame);
+            _frame = frame;
             Frame++;
         }
         else _frame = nullptr;
     }
 }
 
+void Video::Seek(int frame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!_vid_cap || frame <= Frame) return;
+
+    // Fall back to grabbing, which still skips converting the frames.
+    if(_vid_cap->set(cv::CAP_PROP_POS_FRAMES, frame))
+        Frame = frame;
+    else
+        while(Frame < frame && _vid_cap->grab())
+            Frame++;
+}
+
+void Video::SetFramePool(std::shared_ptr<FramePool> pool)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pool = pool;
+}
+
+const std::string& Video::GetPath() const
+{
+    return _filepath;
+}
+
 std::shared_ptr<cv::Mat> Video::Get() const
 {
     std::lock_guard<std::mutex> lock(_mutex);
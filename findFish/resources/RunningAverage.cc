@@ -0,0 +1,102 @@
+#include "includes/RunningAverage.h"
+
+#include <opencv2/core/hal/intrin.hpp>
+
+#include <cstdlib>
+
+// The background keeps 7 fractional bits, so 255 << 7 still fits in a short,
+// and the difference of a pixel and the background never overflows.
+#define FRACTION_BITS 7
+
+RunningAverage::RunningAverage(int threshold, int shift)
+    : _threshold{threshold}, _shift{shift}
+{
+}
+
+int RunningAverage::Apply(const cv::Mat& frame, cv::Mat& mask, bool update)
+{
+    cv::Mat gray;
+    if(frame.channels() == 3)
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+    else
+        gray = frame;
+
+    mask.create(gray.size(), CV_8UC1);
+
+    // The first frame becomes the background, so nothing is moving yet.
+    if(_background.empty() || _background.size() != gray.size())
+    {
+        gray.convertTo(_background, CV_16S, 1 << FRACTION_BITS);
+        mask.setTo(cv::Scalar(0));
+        return 0;
+    }
+
+    const short threshold = (short)(_threshold << FRACTION_BITS);
+    int changed = 0;
+    for(int y = 0; y < gray.rows; y++)
+    {
+        const uchar* src = gray.ptr<uchar>(y);
+        short* bg = _background.ptr<short>(y);
+        uchar* dst = mask.ptr<uchar>(y);
+
+        int x = 0;
+#if CV_SIMD
+        const cv::v_uint16 v_threshold = cv::vx_setall_u16((unsigned short)threshold);
+
+        // Each lane counts at most two pixels per step, so a row never
+        // overflows the 16 bit counters.
+        cv::v_uint16 v_changed = cv::vx_setzero_u16();
+        for(; x <= gray.cols - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes)
+        {
+            cv::v_uint16 lo, hi;
+            cv::v_expand(cv::vx_load(src + x), lo, hi);
+
+            cv::v_int16 bg_lo = cv::vx_load(bg + x);
+            cv::v_int16 bg_hi = cv::vx_load(bg + x + cv::v_int16::nlanes);
+            cv::v_int16 diff_lo = cv::v_reinterpret_as_s16(lo << FRACTION_BITS) - bg_lo;
+            cv::v_int16 diff_hi = cv::v_reinterpret_as_s16(hi << FRACTION_BITS) - bg_hi;
+
+            if(update)
+            {
+                cv::v_store(bg + x, bg_lo + (diff_lo >> _shift));
+                cv::v_store(bg + x + cv::v_int16::nlanes, bg_hi + (diff_hi >> _shift));
+            }
+
+            cv::v_uint16 moved_lo = cv::v_abs(diff_lo) > v_threshold;
+            cv::v_uint16 moved_hi = cv::v_abs(diff_hi) > v_threshold;
+            cv::v_store(dst + x, cv::v_pack(moved_lo, moved_hi));
+            v_changed += (moved_lo >> 15) + (moved_hi >> 15);
+        }
+
+        cv::v_uint32 changed_lo, changed_hi;
+        cv::v_expand(v_changed, changed_lo, changed_hi);
+        changed += (int)cv::v_reduce_sum(changed_lo + changed_hi);
+#endif
+        for(; x < gray.cols; x++)
+        {
+            int diff = (src[x] << FRACTION_BITS) - bg[x];
+            if(update) bg[x] = (short)(bg[x] + (diff >> _shift));
+
+            bool moved = std::abs(diff) > threshold;
+            dst[x] = moved ? 255 : 0;
+            changed += moved;
+        }
+    }
+#if CV_SIMD
+    cv::vx_cleanup();
+#endif
+
+    return changed;
+}
+
+void RunningAverage::apply(cv::InputArray image, cv::OutputArray fgmask, double learningRate)
+{
+    cv::Mat mask;
+    Apply(image.getMat(), mask, learningRate != 0);
+    mask.copyTo(fgmask);
+}
+
+void RunningAverage::getBackgroundImage(cv::OutputArray backgroundImage) const
+{
+    _background.convertTo(backgroundImage, CV_8U, 1.0 / (1 << FRACTION_BITS));
+}
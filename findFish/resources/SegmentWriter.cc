@@ -0,0 +1,126 @@
+#include "includes/SegmentWriter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <opencv2/core/utils/filesystem.hpp>
+
+SegmentWriter::SegmentWriter(std::string dir, std::string name, int fourcc, double fps, cv::Size size,
+                             SegmentWriter::Settings settings)
+    : Config{settings}, _dir{dir}, _name{name}, _fourcc{fourcc}, _fps{fps}, _size{size},
+      _total_frames{0}, _closed{false}
+{
+    if(Config.SegmentFrames < 1)
+        throw std::runtime_error("Segments need at least one frame!");
+    cv::utils::fs::createDirectories(_dir);
+}
+
+SegmentWriter::~SegmentWriter()
+{
+    try
+    {
+        if(!_closed && _writer.isOpened())
+            FinishSegment();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << " !> " << e.what() << '\n';
+    }
+}
+
+void SegmentWriter::Write(const cv::Mat& frame)
+{
+    if(_closed) return;
+
+    if(_writer.isOpened() && _current.frames >= Config.SegmentFrames)
+        FinishSegment();
+
+    if(!_writer.isOpened())
+    {
+        _current = VideoSegment();
+        _current.index = (int)_segments.size();
+        _current.frame_start = _total_frames;
+        _current.file = SegmentName(_name, _current.index, Config.Extension);
+        if(!_writer.open(cv::utils::fs::join(_dir, _current.file), _fourcc, _fps, _size, true))
+            throw std::runtime_error("Segment \"" + _current.file + "\" could not be opened!");
+    }
+
+    _writer << frame;
+    _current.frames++;
+    _total_frames++;
+}
+
+void SegmentWriter::Close()
+{
+    if(_closed) return;
+    _closed = true;
+
+    if(_writer.isOpened())
+        FinishSegment();
+    else
+        WriteManifest();
+}
+
+const std::vector<VideoSegment>& SegmentWriter::GetSegments() const
+{
+    return _segments;
+}
+
+std::string SegmentWriter::GetManifestPath() const
+{
+    return cv::utils::fs::join(_dir, _name + ".json");
+}
+
+JSON SegmentWriter::ToJSON() const
+{
+    JSON segments("segments");
+    for(auto& segment : _segments)
+    {
+        JSON json("Segment_" + std::to_string(segment.index));
+        json.AddKeyValue("file", segment.file);
+        json.AddKeyValue("frame_start", std::to_string(segment.frame_start));
+        json.AddKeyValue("frames", std::to_string(segment.frames));
+        json.BuildJSONObject();
+        segments.AddObject(json);
+    }
+    segments.BuildJSONObjectArray();
+
+    JSON manifest("Manifest");
+    manifest.AddRawValue("complete", _closed ? "true" : "false");
+    manifest.AddKeyValue("fps", std::to_string(_fps));
+    manifest.AddKeyValue("frames", std::to_string(_total_frames));
+    manifest.AddObject(segments);
+    manifest.BuildJSONObject();
+    return manifest;
+}
+
+std::string SegmentWriter::SegmentName(const std::string& name, int index, const std::string& extension)
+{
+    char number[16];
+    std::snprintf(number, sizeof(number), "%03d", index);
+    return name + "_" + number + extension;
+}
+
+void SegmentWriter::FinishSegment()
+{
+    _writer.release();
+    _segments.push_back(_current);
+    WriteManifest();
+}
+
+void SegmentWriter::WriteManifest() const
+{
+    // Written next to the manifest and renamed over it, so readers never see
+    // a partial manifest.
+    std::string path = GetManifestPath(), temp = path + ".tmp";
+    {
+        std::ofstream out(temp);
+        if(!out.is_open())
+            throw std::runtime_error("Manifest \"" + path + "\" could not be written!");
+        out << ToJSON().GetJSON();
+    }
+    if(std::rename(temp.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Manifest \"" + path + "\" could not be replaced!");
+}
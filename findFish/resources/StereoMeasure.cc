@@ -0,0 +1,131 @@
+#include "includes/StereoMeasure.h"
+#include "includes/Calibration.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+float RowOverlap(const cv::Rect2f&, const cv::Rect2f&);
+
+StereoMeasure::StereoMeasure(std::shared_ptr<Calibration> calib, Settings settings)
+    : Config{settings}, _calib{calib}
+{
+    if(!_calib || !_calib->IsStereoCalibrated())
+        throw std::runtime_error("Stereo measurement needs a stereo calibration!");
+}
+
+std::vector<StereoMeasure::Measurement> StereoMeasure::MeasureObjects(const std::vector<cv::Rect>& left,
+                                                                      const std::vector<cv::Rect>& right) const
+{
+    std::vector<Measurement> measurements;
+    if(left.empty() || right.empty()) return measurements;
+
+    auto rect_left = RectifyBoxes(left, 0);
+    auto rect_right = RectifyBoxes(right, 1);
+
+    for(auto match : MatchBoxes(rect_left, rect_right))
+    {
+        const cv::Rect2f& l = rect_left[match.first];
+        const cv::Rect2f& r = rect_right[match.second];
+
+        // Measure along the longest side of the box. Both cameras share the
+        // same rows once rectified, so the rows are averaged between them.
+        std::vector<cv::Point2f> points_left(2), points_right(2);
+        if(l.width >= l.height)
+        {
+            float y = (l.y + l.height / 2.f + r.y + r.height / 2.f) / 2.f;
+            points_left[0]  = cv::Point2f(l.x, y);
+            points_left[1]  = cv::Point2f(l.x + l.width, y);
+            points_right[0] = cv::Point2f(r.x, y);
+            points_right[1] = cv::Point2f(r.x + r.width, y);
+        }
+        else
+        {
+            float top = (l.y + r.y) / 2.f, bottom = (l.y + l.height + r.y + r.height) / 2.f;
+            points_left[0]  = cv::Point2f(l.x + l.width / 2.f, top);
+            points_left[1]  = cv::Point2f(l.x + l.width / 2.f, bottom);
+            points_right[0] = cv::Point2f(r.x + r.width / 2.f, top);
+            points_right[1] = cv::Point2f(r.x + r.width / 2.f, bottom);
+        }
+
+        auto world = _calib->TriangulatePoints(points_left, points_right);
+        float length = (float)cv::norm(world[0] - world[1]);
+
+        if(length >= Config.MinLength && length <= Config.MaxLength)
+            measurements.push_back({match.first, match.second, length, l, r});
+    }
+
+    return measurements;
+}
+
+std::vector<cv::Rect2f> StereoMeasure::RectifyBoxes(const std::vector<cv::Rect>& boxes, int index) const
+{
+    std::vector<cv::Point2f> corners;
+    corners.reserve(boxes.size() * 4);
+    for(auto& box : boxes)
+    {
+        corners.push_back(cv::Point2f(box.x, box.y));
+        corners.push_back(cv::Point2f(box.x + box.width, box.y));
+        corners.push_back(cv::Point2f(box.x, box.y + box.height));
+        corners.push_back(cv::Point2f(box.x + box.width, box.y + box.height));
+    }
+
+    auto rectified = _calib->RectifyPoints(corners, index);
+
+    std::vector<cv::Rect2f> rect_boxes;
+    rect_boxes.reserve(boxes.size());
+    for(size_t i = 0; i < rectified.size(); i += 4)
+    {
+        float x0 = std::min(std::min(rectified[i].x, rectified[i+1].x), std::min(rectified[i+2].x, rectified[i+3].x));
+        float x1 = std::max(std::max(rectified[i].x, rectified[i+1].x), std::max(rectified[i+2].x, rectified[i+3].x));
+        float y0 = std::min(std::min(rectified[i].y, rectified[i+1].y), std::min(rectified[i+2].y, rectified[i+3].y));
+        float y1 = std::max(std::max(rectified[i].y, rectified[i+1].y), std::max(rectified[i+2].y, rectified[i+3].y));
+        rect_boxes.push_back(cv::Rect2f(x0, y0, x1 - x0, y1 - y0));
+    }
+
+    return rect_boxes;
+}
+
+std::vector<std::pair<int, int>> StereoMeasure::MatchBoxes(const std::vector<cv::Rect2f>& left,
+                                                           const std::vector<cv::Rect2f>& right) const
+{
+    struct Candidate { float score; int left, right; };
+
+    std::vector<Candidate> candidates;
+    for(size_t i = 0; i < left.size(); i++)
+        for(size_t j = 0; j < right.size(); j++)
+        {
+            float overlap = RowOverlap(left[i], right[j]);
+            if(overlap < Config.MinRowOverlap) continue;
+
+            float heights = std::min(left[i].height, right[j].height) / std::max(left[i].height, right[j].height);
+            candidates.push_back({overlap * heights, (int)i, (int)j});
+        }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    std::vector<bool> used_left(left.size(), false), used_right(right.size(), false);
+    std::vector<std::pair<int, int>> matches;
+    for(auto& c : candidates)
+        if(!used_left[c.left] && !used_right[c.right])
+        {
+            used_left[c.left] = used_right[c.right] = true;
+            matches.push_back(std::make_pair(c.left, c.right));
+        }
+
+    return matches;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+float RowOverlap(const cv::Rect2f& a, const cv::Rect2f& b)
+{
+    float top = std::max(a.y, b.y);
+    float bottom = std::min(a.y + a.height, b.y + b.height);
+    float span = std::max(a.y + a.height, b.y + b.height) - std::min(a.y, b.y);
+
+    return (bottom > top && span > 0.f) ? (bottom - top) / span : 0.f;
+}
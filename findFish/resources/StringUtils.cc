@@ -0,0 +1,71 @@
+#include "includes/StringUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+StringSlice::StringSlice()
+    : _data{""}, _size{0}
+{
+}
+
+StringSlice::StringSlice(const std::string& str)
+    : _data{str.data()}, _size{str.size()}
+{
+}
+
+StringSlice::StringSlice(const char* data, size_t size)
+    : _data{data}, _size{size}
+{
+}
+
+size_t StringSlice::Find(const char* needle) const
+{
+    size_t n = std::strlen(needle);
+    const char* found = std::search(_data, _data + _size, needle, needle + n);
+    return found == _data + _size && n > 0 ? std::string::npos : (size_t)(found - _data);
+}
+
+StringSlice StringSlice::Substr(size_t pos, size_t n) const
+{
+    pos = std::min(pos, _size);
+    return StringSlice(_data + pos, std::min(n, _size - pos));
+}
+
+StringSlice StringSlice::Trim() const
+{
+    size_t begin = 0, end = _size;
+    while(begin < end && std::isspace((unsigned char)_data[begin])) begin++;
+    while(end > begin && std::isspace((unsigned char)_data[end - 1])) end--;
+    return StringSlice(_data + begin, end - begin);
+}
+
+std::string StringSlice::ToString() const
+{
+    return std::string(_data, _size);
+}
+
+bool StringSlice::operator==(const StringSlice& other) const
+{
+    return _size == other._size && std::equal(_data, _data + _size, other._data);
+}
+
+std::vector<StringSlice> Tokenize(StringSlice str, char delimiter)
+{
+    std::vector<StringSlice> tokens;
+    const char* begin = str.Data();
+    const char* end = str.Data() + str.Size();
+    while(true)
+    {
+        const char* next = std::find(begin, end, delimiter);
+        StringSlice token = StringSlice(begin, next - begin).Trim();
+        if(next == end)
+        {
+            if(!token.Empty()) tokens.push_back(token);
+            break;
+        }
+        tokens.push_back(token);
+        begin = next + 1;
+    }
+    return tokens;
+}
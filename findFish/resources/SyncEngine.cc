@@ -0,0 +1,338 @@
+#include "includes/SyncEngine.h"
+#include "includes/EventDetector.h"
+#include "includes/JsonBuilder.h"
+#include "includes/FileHash.h"
+
+#include <opencv2/videoio.hpp>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+// Frames are shrunk to this width before measuring their brightness.
+#define BRIGHTNESS_WIDTH 64
+
+// Fewest overlapping frames to trust a correlation with.
+#define MIN_CORRELATION_FRAMES 8
+
+double Brightness(const cv::Mat& frame);
+double Correlation(const std::vector<double>&, const std::vector<double>&, int offset);
+std::string PairKey(uint64_t left, uint64_t right);
+
+/// Holds an advisory lock on a file for as long as it lives.
+struct FileLock
+{
+    /// Waits for the lock, or goes without one if the file cannot be opened.
+    /// \param[in] file The path of the lock file, which is created if needed.
+    /// \param[in] bExclusive Whether to lock for writing rather than reading.
+    FileLock(const std::string& file, bool bExclusive);
+    ~FileLock();
+
+    int fd;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Sync Result
+JSON SyncResult::ToJSON() const
+{
+    auto info = url.empty() ? std::map<std::string, std::string>() : QREvent::GetGeoURIValues(url);
+    info["frame"] = std::to_string(qr_first[0]);
+    info["offset_frames"] = std::to_string(offset);
+    info["offset_refinement"] = std::to_string(refinement);
+    info["offset_confidence"] = std::to_string(confidence);
+    info["qr_first_left"] = std::to_string(qr_first[0]);
+    info["qr_last_left"] = std::to_string(qr_last[0]);
+    info["qr_first_right"] = std::to_string(qr_first[1]);
+    info["qr_last_right"] = std::to_string(qr_last[1]);
+    info["start_left"] = std::to_string(start[0]);
+    info["start_right"] = std::to_string(start[1]);
+    return JSON("Event_QRCode", info);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sync Engine
+SyncEngine::SyncEngine(SyncEngine::Settings settings)
+    : Config{settings}
+{
+}
+
+SyncResult SyncEngine::Sync(const std::string& left, const std::string& right) const
+{
+    Scan scans[2] = { ScanVideo(left), ScanVideo(right) };
+
+    SyncResult result;
+    for(int i = 0; i < 2; i++)
+    {
+        result.qr_first[i] = scans[i].qr_first;
+        result.qr_last[i] = scans[i].qr_last;
+    }
+    result.url = !scans[0].url.empty() ? scans[0].url : scans[1].url;
+    if(scans[0].qr_first == -1 || scans[1].qr_first == -1 || result.url.empty())
+        return result;
+
+    // The first and last frames depend on blur, but the middle of the stretch
+    // where the code is visible hardly moves.
+    result.offset = (int)std::lround(((scans[1].qr_first + scans[1].qr_last) -
+                                      (scans[0].qr_first + scans[0].qr_last)) / 2.0);
+
+    if(Config.bRefineBrightness)
+    {
+        double confidence = 0.0;
+        double correction = RefineOffset(scans[0].brightness, scans[1].brightness, result.offset,
+                                         Config.MaxRefineShift, confidence);
+        result.confidence = confidence;
+        if(confidence >= Config.MinConfidence)
+        {
+            int frames = (int)std::lround(correction);
+            result.offset += frames;
+            result.refinement = correction - frames;
+        }
+    }
+
+    // Start after the QR code is gone from both videos.
+    result.start[0] = std::max(scans[0].qr_last, scans[1].qr_last - result.offset) + 1;
+    result.start[1] = result.start[0] + result.offset;
+    result.found = true;
+    return result;
+}
+
+double SyncEngine::RefineOffset(const std::vector<double>& left, const std::vector<double>& right,
+                                int offset, int max_shift, double& confidence)
+{
+    // Ties, e.g. when neither video changes at all, keep the estimate.
+    std::vector<double> scores;
+    for(int shift = -max_shift; shift <= max_shift; shift++)
+        scores.push_back(Correlation(left, right, offset + shift));
+
+    int best = max_shift;
+    for(int i = 0; i < (int)scores.size(); i++)
+        if(scores[i] > scores[best]) best = i;
+    confidence = scores[best];
+
+    // Fit a parabola through the peak and its neighbours for a sub-frame shift.
+    double correction = best - max_shift;
+    if(best > 0 && best + 1 < (int)scores.size())
+    {
+        double denominator = scores[best - 1] - 2 * scores[best] + scores[best + 1];
+        if(denominator < 0)
+            correction += 0.5 * (scores[best - 1] - scores[best + 1]) / denominator;
+    }
+    return correction;
+}
+
+void SyncEngine::SetMetrics(std::shared_ptr<Metrics> metrics)
+{
+    _metrics = metrics;
+}
+
+SyncEngine::Scan SyncEngine::ScanVideo(const std::string& file) const
+{
+    cv::VideoCapture cap(file);
+    if(!cap.isOpened())
+        throw std::runtime_error("Video \"" + file + "\" could not be opened!");
+
+    Scan scan;
+    cv::QRCodeDetector detector;
+    cv::Mat frame;
+    int gap = 0;
+    for(int i = 0; i < Config.MaxSearchFrames && cap.read(frame); i++)
+    {
+        scan.brightness.push_back(Brightness(frame));
+
+        // Past the QR code only the brightness is needed for refining.
+        if(scan.qr_last != -1 && gap > Config.MaxQRGap)
+        {
+            if(!Config.bRefineBrightness || i - scan.qr_last > Config.MaxQRGap + Config.RefineFrames)
+                break;
+            continue;
+        }
+
+        // Decoding is only needed once, finding the code is enough after.
+        cv::Mat points;
+        bool bVisible;
+        {
+            Metrics::ScopedTimer timer(_metrics.get(), "qr");
+            bVisible = detector.detect(frame, points);
+            if(bVisible && scan.url.empty())
+                scan.url = detector.decode(frame, points);
+        }
+
+        if(bVisible)
+        {
+            if(scan.qr_first == -1) scan.qr_first = i;
+            scan.qr_last = i;
+            gap = 0;
+        }
+        else if(scan.qr_last != -1) gap++;
+    }
+
+    return scan;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sync Cache
+SyncCache::SyncCache(std::string file, SyncEngine::Settings settings)
+    : _file{file}, _settings{settings}
+{
+    FileLock lock(_file + ".lock", false);
+    Read(_results);
+}
+
+bool SyncCache::Find(uint64_t left, uint64_t right, SyncResult& result) const
+{
+    auto it = _results.find(PairKey(left, right));
+    if(it == _results.end()) return false;
+
+    result = it->second;
+    return true;
+}
+
+void SyncCache::Store(uint64_t left, uint64_t right, const SyncResult& result)
+{
+    _results[PairKey(left, right)] = result;
+}
+
+void SyncCache::Write() const
+{
+    // Pairs other processes cached in the meantime are kept, and the file is
+    // replaced at once, so it is never seen half written.
+    FileLock lock(_file + ".lock", true);
+    std::map<std::string, SyncResult> results;
+    Read(results);
+    for(auto& pair : _results)
+        results[pair.first] = pair.second;
+
+    std::string temp = _file + ".tmp";
+    {
+        cv::FileStorage fs(temp, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_YAML);
+        if(!fs.isOpened()) return;
+
+        fs << "search_frames" << _settings.MaxSearchFrames;
+        fs << "max_qr_gap" << _settings.MaxQRGap;
+        fs << "refine" << (int)_settings.bRefineBrightness;
+        fs << "refine_frames" << _settings.RefineFrames;
+        fs << "max_refine_shift" << _settings.MaxRefineShift;
+        fs << "min_confidence" << _settings.MinConfidence;
+        fs << "pairs" << "[";
+        for(auto& pair : results)
+        {
+            const SyncResult& result = pair.second;
+            fs << "{" << "pair" << "fp_" + pair.first
+                      << "qr_first_left" << result.qr_first[0] << "qr_first_right" << result.qr_first[1]
+                      << "qr_last_left" << result.qr_last[0] << "qr_last_right" << result.qr_last[1]
+                      << "offset" << result.offset << "refinement" << result.refinement
+                      << "confidence" << result.confidence
+                      << "start_left" << result.start[0] << "start_right" << result.start[1]
+                      << "url" << result.url << "}";
+        }
+        fs << "]";
+    }
+    std::rename(temp.c_str(), _file.c_str());
+}
+
+void SyncCache::Read(std::map<std::string, SyncResult>& results) const
+{
+    cv::FileStorage fs(_file, cv::FileStorage::READ);
+    if(!fs.isOpened()) return;
+
+    // Results only carry over when they were searched for the same way.
+    SyncEngine::Settings cached;
+    int refine = 0;
+    fs["search_frames"] >> cached.MaxSearchFrames;
+    fs["max_qr_gap"] >> cached.MaxQRGap;
+    fs["refine"] >> refine;
+    fs["refine_frames"] >> cached.RefineFrames;
+    fs["max_refine_shift"] >> cached.MaxRefineShift;
+    fs["min_confidence"] >> cached.MinConfidence;
+    if(fs["max_qr_gap"].empty() || cached.MaxSearchFrames != _settings.MaxSearchFrames ||
+       cached.MaxQRGap != _settings.MaxQRGap || (refine != 0) != _settings.bRefineBrightness ||
+       cached.RefineFrames != _settings.RefineFrames || cached.MaxRefineShift != _settings.MaxRefineShift ||
+       cached.MinConfidence != _settings.MinConfidence)
+        return;
+
+    for(auto node : fs["pairs"])
+    {
+        SyncResult result;
+        result.found = true;
+        result.qr_first[0] = (int)node["qr_first_left"];
+        result.qr_first[1] = (int)node["qr_first_right"];
+        result.qr_last[0] = (int)node["qr_last_left"];
+        result.qr_last[1] = (int)node["qr_last_right"];
+        result.offset = (int)node["offset"];
+        result.refinement = (double)node["refinement"];
+        result.confidence = (double)node["confidence"];
+        result.start[0] = (int)node["start_left"];
+        result.start[1] = (int)node["start_right"];
+        result.url = (std::string)node["url"];
+
+        // Fingerprints are stored with a prefix so YAML never reads them as numbers.
+        std::string key = (std::string)node["pair"];
+        results[key.substr(key.find('_') + 1)] = result;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+double Brightness(const cv::Mat& frame)
+{
+    cv::Mat small;
+    cv::resize(frame, small, cv::Size(BRIGHTNESS_WIDTH, std::max(1, frame.rows * BRIGHTNESS_WIDTH / std::max(frame.cols, 1))),
+               0, 0, cv::INTER_AREA);
+    cv::Scalar mean = cv::mean(small);
+    return (mean[0] + mean[1] + mean[2]) / std::max(small.channels(), 1);
+}
+
+double Correlation(const std::vector<double>& left, const std::vector<double>& right, int offset)
+{
+    // Frame i of the left video is compared to frame i + offset of the right.
+    int begin = std::max(0, -offset), end = std::min((int)left.size(), (int)right.size() - offset);
+    int n = end - begin;
+    if(n < MIN_CORRELATION_FRAMES)
+        return 0.0;
+
+    double mean_l = 0, mean_r = 0;
+    for(int i = begin; i < end; i++)
+    {
+        mean_l += left[i];
+        mean_r += right[i + offset];
+    }
+    mean_l /= n;
+    mean_r /= n;
+
+    double cov = 0, var_l = 0, var_r = 0;
+    for(int i = begin; i < end; i++)
+    {
+        double l = left[i] - mean_l, r = right[i + offset] - mean_r;
+        cov += l * r;
+        var_l += l * l;
+        var_r += r * r;
+    }
+    return var_l > 0 && var_r > 0 ? cov / std::sqrt(var_l * var_r) : 0.0;
+}
+
+std::string PairKey(uint64_t left, uint64_t right)
+{
+    return HashToString(left) + "_" + HashToString(right);
+}
+
+FileLock::FileLock(const std::string& file, bool bExclusive)
+    : fd{open(file.c_str(), O_RDWR | O_CREAT, 0644)}
+{
+    if(fd < 0) return;
+    while(flock(fd, bExclusive ? LOCK_EX : LOCK_SH) != 0 && errno == EINTR)
+        continue;
+}
+
+FileLock::~FileLock()
+{
+    if(fd >= 0) close(fd);
+}
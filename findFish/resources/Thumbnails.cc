@@ -0,0 +1,198 @@
+#include "includes/Thumbnails.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+cv::Mat Shrink(const cv::Mat& image, cv::Size fit);
+cv::Mat ToHeight(const cv::Mat& image, int height);
+void WriteBytes(const std::vector<uchar>& bytes, const std::string& file);
+
+ThumbnailBuilder::ThumbnailBuilder(ThumbnailBuilder::Settings settings)
+    : Config{settings}, _open{false}, _start{0}, _stride{1},
+      _best_area{0.0}, _best_frame{-1}, _best_camera{-1}
+{
+}
+
+void ThumbnailBuilder::Start(int frame)
+{
+    _open = true;
+    _start = frame;
+    _stride = 1;
+    _samples.clear();
+    _samples.reserve(2 * std::max(Config.Keyframes, 1));
+
+    _best_area = 0.0;
+    _best_frame = _best_camera = -1;
+    _best_box = cv::Rect();
+    _best.release();
+}
+
+void ThumbnailBuilder::Add(int frame, const cv::Mat frames[2], const std::vector<cv::Rect> boxes[2])
+{
+    if(!_open || frames[0].empty() || frames[1].empty()) return;
+
+    if((frame - _start) % _stride == 0)
+    {
+        cv::Mat pair[2];
+        for(int i = 0; i < 2; i++)
+            pair[i] = ToHeight(frames[i], Config.Height);
+        cv::Mat sample;
+        cv::hconcat(pair[0], pair[1], sample);
+        _samples.push_back(std::make_pair(frame, sample));
+
+        // Keeping every other sample leaves them evenly spaced at twice the
+        // stride, so long events take no more memory than short ones.
+        if(_samples.size() >= 2 * (size_t)std::max(Config.Keyframes, 1))
+        {
+            for(size_t i = 1; 2 * i < _samples.size(); i++)
+                _samples[i] = std::move(_samples[2 * i]);
+            _samples.resize((_samples.size() + 1) / 2);
+            _stride *= 2;
+        }
+    }
+
+    // Only the close up of the largest object is kept.
+    for(int i = 0; i < 2; i++)
+        for(auto& box : boxes[i])
+        {
+            if(box.area() <= _best_area) continue;
+
+            int pad_x = (int)(box.width * Config.Padding), pad_y = (int)(box.height * Config.Padding);
+            cv::Rect crop = cv::Rect(box.x - pad_x, box.y - pad_y, box.width + 2 * pad_x, box.height + 2 * pad_y) &
+                            cv::Rect(0, 0, frames[i].cols, frames[i].rows);
+            if(crop.empty()) continue;
+
+            _best_area = box.area();
+            _best_frame = frame;
+            _best_camera = i;
+            _best_box = box;
+            _best = Shrink(frames[i](crop), cv::Size(Config.KeyframeSize, Config.KeyframeSize));
+        }
+}
+
+EventThumbnails ThumbnailBuilder::Finish()
+{
+    EventThumbnails thumbnails;
+    if(!_open) return thumbnails;
+    _open = false;
+
+    // Evenly spaced samples, always including the first and the last.
+    if(!_samples.empty())
+    {
+        size_t n = std::min(_samples.size(), (size_t)std::max(Config.Keyframes, 1));
+        std::vector<cv::Mat> strip;
+        for(size_t i = 0; i < n; i++)
+        {
+            size_t index = n > 1 ? (size_t)std::lround((double)i * (_samples.size() - 1) / (n - 1)) : 0;
+            strip.push_back(_samples[index].second);
+            thumbnails.strip_frames.push_back(_samples[index].first);
+        }
+
+        cv::Mat image;
+        cv::hconcat(strip, image);
+        thumbnails.strip = Encode(image);
+    }
+
+    if(!_best.empty())
+    {
+        thumbnails.keyframe = Encode(_best);
+        thumbnails.keyframe_frame = _best_frame;
+        thumbnails.keyframe_camera = _best_camera;
+        thumbnails.box = _best_box;
+    }
+
+    _samples.clear();
+    _best.release();
+    return thumbnails;
+}
+
+bool ThumbnailBuilder::IsOpen() const
+{
+    return _open;
+}
+
+void ThumbnailBuilder::Write(EventThumbnails& thumbnails, const std::string& base)
+{
+    if(!thumbnails.strip.empty())
+    {
+        thumbnails.strip_file = base + "_strip" + Config.Format;
+        WriteBytes(thumbnails.strip, thumbnails.strip_file);
+        _written.push_back(thumbnails.strip_file);
+        std::vector<uchar>().swap(thumbnails.strip);
+    }
+    if(!thumbnails.keyframe.empty())
+    {
+        thumbnails.keyframe_file = base + "_keyframe" + Config.Format;
+        WriteBytes(thumbnails.keyframe, thumbnails.keyframe_file);
+        _written.push_back(thumbnails.keyframe_file);
+        std::vector<uchar>().swap(thumbnails.keyframe);
+    }
+}
+
+void ThumbnailBuilder::Rename(EventThumbnails& thumbnails, const std::string& base)
+{
+    if(!thumbnails.strip_file.empty())
+        Move(thumbnails.strip_file, base + "_strip" + Config.Format);
+    if(!thumbnails.keyframe_file.empty())
+        Move(thumbnails.keyframe_file, base + "_keyframe" + Config.Format);
+}
+
+void ThumbnailBuilder::RemoveUnused()
+{
+    for(auto& file : _written)
+        std::remove(file.c_str());
+    _written.clear();
+}
+
+std::vector<uchar> ThumbnailBuilder::Encode(const cv::Mat& image) const
+{
+    int quality = Config.Format == ".webp" ? cv::IMWRITE_WEBP_QUALITY : cv::IMWRITE_JPEG_QUALITY;
+    std::vector<uchar> bytes;
+    if(!cv::imencode(Config.Format, image, bytes, { quality, Config.Quality }))
+        throw std::runtime_error("Thumbnail could not be encoded as \"" + Config.Format + "\"!");
+    return bytes;
+}
+
+void ThumbnailBuilder::Move(std::string& file, const std::string& to)
+{
+    _written.erase(std::remove(_written.begin(), _written.end(), file), _written.end());
+    if(file != to && std::rename(file.c_str(), to.c_str()) != 0)
+        throw std::runtime_error("Thumbnail \"" + file + "\" could not be renamed!");
+    file = to;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+cv::Mat Shrink(const cv::Mat& image, cv::Size fit)
+{
+    double scale = std::min((double)fit.width / image.cols, (double)fit.height / image.rows);
+    if(scale >= 1.0) return image.clone();
+
+    cv::Mat small;
+    cv::resize(image, small, cv::Size(std::max((int)(image.cols * scale), 1), std::max((int)(image.rows * scale), 1)),
+               0, 0, cv::INTER_AREA);
+    return small;
+}
+
+cv::Mat ToHeight(const cv::Mat& image, int height)
+{
+    // Both cameras end up the same height, so they fit side by side.
+    cv::Mat resized;
+    cv::resize(image, resized, cv::Size(std::max(image.cols * height / std::max(image.rows, 1), 1), height),
+               0, 0, cv::INTER_AREA);
+    return resized;
+}
+
+void WriteBytes(const std::vector<uchar>& bytes, const std::string& file)
+{
+    std::ofstream out(file, std::ios::binary);
+    if(!out.is_open())
+        throw std::runtime_error("Thumbnail \"" + file + "\" could not be written!");
+    out.write((const char*)bytes.data(), bytes.size());
+}
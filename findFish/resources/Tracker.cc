@@ -1,80 +1,120 @@
 #include "includes/Tracker.h"
-#include "includes/EventDetector.h"
+#include "includes/FrameDifference.h"
+#include "includes/RunningAverage.h"
 
 #include <opencv2/imgcodecs.hpp>
+#include <opencv2/bgsegm.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
 
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
 #include <vector>
 
+// Room for this many activity events is made up front, so most videos never
+// reallocate the events while tracking.
+#define RESERVED_EVENTS 256
+
+std::string FileStem(const std::string&);
+
 Tracker::Tracker(Tracker::Settings s)
 {
     Config = s;
-    bkgd_sub_ptr = cv::createBackgroundSubtractorKNN();
+    for(int i = 0; i < 2; i++)
+    {
+        bkgd_sub_ptr[i] = CreateSubtractor(Config);
+        _objects[i] = ObjectTracker(Config.ObjectTracking, i);
+    }
     bIsActive = false;
+    _found_frames = _found_since = 0;
+    _missing_frames = _missing_since = 0;
     GetCascades();
-}
 
-Tracker::~Tracker()
-{
-    for(auto event : ActivityRange)
-        if(event)
-        {
-            delete event;
-            event = nullptr;
-        }
+    if(Config.bUseDnn)
+        _dnn = std::make_unique<DnnDetector>(Config.Dnn);
+
+    ActivityRange.reserve(RESERVED_EVENTS);
 }
 
-void Tracker::CreateMask(cv::Mat& frame)
+void Tracker::CreateMask(cv::Mat& frame, int camera, double learning_rate)
 {
     if(!frame.empty())
     {
-        // Background subtraction method.
-        bkgd_sub_ptr->apply(frame, _mask);
-
-        int sigmaX = 10, sigmaY = 10, ksize = 9;
-        
-        cv::Mat kernel = getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * sigmaX + 1, 2 * sigmaY + 1), cv::Point(sigmaX, sigmaY));
-
-        cv::GaussianBlur(_mask, _mask, cv::Size(ksize, ksize), sigmaX, sigmaY);
-        cv::morphologyEx(_mask, _mask, cv::MORPH_CLOSE, cv::getGaussianKernel(ksize, sigmaX));
-        
-        cv::dilate(_mask, _mask, kernel, cv::Point(sigmaX, sigmaY));
-        cv::erode(_mask, _mask, kernel, cv::Point(sigmaX, sigmaY));
-
-        cv::threshold(_mask, _mask, Config.MinThreshold, Config.MaxThreshold, cv::THRESH_BINARY);
-    
-        /*
-        // Haar Cascade method.
-        for(auto cascade : cascades)
+        cv::Mat& mask = _mask[camera];
+        // Only the detector needs the frame after the objects are found, and
+        // only until the frame is checked for activity.
+        if(_dnn) _frame[camera] = frame;
+
+        // The running average counts changed pixels while subtracting, so
+        // frames with nothing moving can stop here.
+        auto running_avg = dynamic_cast<RunningAverage*>(bkgd_sub_ptr[camera].get());
         {
-            std::vector<cv::Rect> objects;
-            cascade.second->detectMultiScale(frame, objects);
+            Metrics::ScopedTimer timer(_metrics.get(), "subtract");
+            if(running_avg)
+            {
+                if(running_avg->Apply(frame, mask, learning_rate != 0) < Config.MinChangedPixels)
+                {
+                    contours[camera].clear();
+                    _species[camera].clear();
+                    return;
+                }
+            }
+            // Background subtraction method.
+            else bkgd_sub_ptr[camera]->apply(frame, mask, learning_rate);
+        }
+
+        {
+            Metrics::ScopedTimer timer(_metrics.get(), "morphology");
+            int sigmaX = 10, sigmaY = 10, ksize = 9;
+            
+            cv::Mat kernel = getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * sigmaX + 1, 2 * sigmaY + 1), cv::Point(sigmaX, sigmaY));
+
+            cv::GaussianBlur(mask, mask, cv::Size(ksize, ksize), sigmaX, sigmaY);
+            cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, cv::getGaussianKernel(ksize, sigmaX));
+            
+            cv::dilate(mask, mask, kernel, cv::Point(sigmaX, sigmaY));
+            cv::erode(mask, mask, kernel, cv::Point(sigmaX, sigmaY));
+
+            cv::threshold(mask, mask, Config.MinThreshold, Config.MaxThreshold, cv::THRESH_BINARY);
         }
-        */
 
-        GetObjectContours(frame);
+        {
+            Metrics::ScopedTimer timer(_metrics.get(), "contours");
+            GetObjectContours(frame, camera);
+        }
+        {
+            Metrics::ScopedTimer timer(_metrics.get(), "species");
+            DetectSpecies(frame, camera);
+        }
     }
 }
 
-void Tracker::GetObjectContours(cv::Mat& frame)
+void Tracker::GetObjectContours(cv::Mat& frame, int camera)
 {
-    contours.clear();
+    contours[camera].clear();
+
+    // Most frames are empty water, so skip edge and contour extraction unless
+    // part of the mask has enough foreground.
+    if(Config.bUseActivityGate && !HasActivity(_mask[camera]))
+        return;
+
     int thresh = 8500;
 
     cv::Mat canny_output;
     std::vector<cv::Vec4i> hierarchy;
 
     // Detect edges using canny
-    cv::Canny(_mask, canny_output, thresh, thresh * 2, 5);
-    cv::findContours(canny_output, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
+    cv::Canny(_mask[camera], canny_output, thresh, thresh * 2, 5);
+    cv::findContours(canny_output, contours[camera], hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
 
     if(Config.bDrawContours)
     {
         cv::RNG rng(12345);
         cv::Mat drawing = cv::Mat::zeros(canny_output.size(), CV_8UC3);
-        std::vector<std::vector<cv::Point2f>> prec_conts(contours.size());
-        for (size_t i = 0; i < contours.size(); i++)
+        std::vector<std::vector<cv::Point2f>> prec_conts(contours[camera].size());
+        for (size_t i = 0; i < contours[camera].size(); i++)
         {
-            cv::approxPolyDP(contours[i], prec_conts[i], 3, true);
+            cv::approxPolyDP(contours[camera][i], prec_conts[i], 3, true);
             cv::Scalar colour = cv::Scalar(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
             //cv::drawContours(frame, contours, i, colour, -1, 8, hierarchy, 0, cv::Point());
 
@@ -84,47 +124,343 @@ void Tracker::GetObjectContours(cv::Mat& frame)
     }
 }
 
+bool Tracker::ProbeFrame(cv::Mat& frame, int camera)
+{
+    // The mask, objects and species of the last tracked frame are set aside
+    // while probing, and put back afterwards.
+    cv::Mat mask, held;
+    std::vector<std::vector<cv::Point>> found;
+    std::vector<std::string> species;
+    std::swap(mask, _mask[camera]);
+    std::swap(held, _frame[camera]);
+    std::swap(found, contours[camera]);
+    std::swap(species, _species[camera]);
+
+    CreateMask(frame, camera, 0);
+    bool bFound = !contours[camera].empty();
+
+    std::swap(mask, _mask[camera]);
+    std::swap(held, _frame[camera]);
+    std::swap(found, contours[camera]);
+    std::swap(species, _species[camera]);
+    return bFound;
+}
+
+void Tracker::SkipFrame(const SkippedFrame& skipped)
+{
+    _skipped.push_back(skipped);
+}
+
+size_t Tracker::GetSkippedCount() const
+{
+    return _skipped.size() + _skipped_before.size();
+}
+
+void Tracker::BackdateActivity(int frame)
+{
+    if(bIsActive && !ActivityRange.empty())
+        ActivityRange.back().BackdateStart(frame);
+}
+
+void Tracker::EndActivity(int& frame)
+{
+    // Objects that were already gone left at the start of the empty frames.
+    if(bIsActive)
+        CloseActivity(_missing_frames > 0 ? _missing_since : frame);
+    _found_frames = _missing_frames = 0;
+    _skipped.clear();
+    _skipped_before.clear();
+
+    FilterEvents(ActivityRange, Config);
+}
+
+void Tracker::AttachTracks(ActivityEvent& event)
+{
+    for(auto& objects : _objects)
+        for(auto& track : objects.Flush())
+            event.AddTrack(track);
+}
+
+void Tracker::AttachDetections(ActivityEvent& event)
+{
+    if(!_dnn) return;
+
+    for(auto& detection : _dnn->Flush())
+        event.AddDetection(detection);
+}
+
+void Tracker::CloseActivity(int frame)
+{
+    bIsActive = false;
+    if(ActivityRange.empty() || !ActivityRange.back().IsActive())
+        return;
+
+    ActivityEvent& event = ActivityRange.back();
+    AttachTracks(event);
+    AttachDetections(event);
+    event.EndEvent(frame);
+}
+
+void Tracker::BackfillActivity()
+{
+    // The skipped frames are only compared against the background, so finding
+    // the start does not disturb what the tracker has learned.
+    for(auto& skip : _skipped_before)
+    {
+        bool bFound = false;
+        for(int i = 0; i < 2; i++)
+            bFound = ProbeFrame(*skip.frames[i], i) || bFound;
+
+        if(bFound)
+        {
+            BackdateActivity(skip.frame_num);
+            return;
+        }
+    }
+}
+
+bool Tracker::IsActive() const
+{
+    return bIsActive;
+}
+
+bool Tracker::HasActivity(const cv::Mat& mask) const
+{
+    if(mask.empty()) return false;
+
+    int tile = std::max(Config.GateTileSize, 1);
+    for(int y = 0; y < mask.rows; y += tile)
+        for(int x = 0; x < mask.cols; x += tile)
+        {
+            cv::Rect roi(x, y, std::min(tile, mask.cols - x), std::min(tile, mask.rows - y));
+            if(cv::countNonZero(mask(roi)) > Config.MinTileArea)
+                return true;
+        }
+
+    return false;
+}
+
 void Tracker::CheckForActivity(int& CurrentFrame)
 {
-    if (!contours.empty())
+    if(Config.bTrackObjects)
+        for(int i = 0; i < 2; i++)
+            _objects[i].Update(GetBoundingBoxes(i), CurrentFrame);
+
+    // A flickering mask does not start or end events until it has settled.
+    bool bFound = !contours[0].empty() || !contours[1].empty(), bOpened = false;
+    if(bFound)
     {
-        if(!bIsActive)
+        _missing_frames = 0;
+        if(_found_frames++ == 0)
         {
-            ActivityRange.resize(ActivityRange.size() + 1);
-            if(!ActivityRange[ActivityRange.size()-1])
-            {
-                ActivityRange[ActivityRange.size()-1] = new ActivityEvent(int(ActivityRange.size()), CurrentFrame, -1);
-                bIsActive = true;
-            } 
-            else ActivityRange.resize(ActivityRange.size() - 1);
+            // An event opened by this run starts at its first frame, or at
+            // some frame skipped before it.
+            _found_since = CurrentFrame;
+            _skipped_before.swap(_skipped);
+        }
+        if(!bIsActive && _found_frames >= Config.EnterFrames)
+        {
+            ActivityRange.emplace_back(int(ActivityRange.size() + 1), _found_since, -1);
+            bIsActive = bOpened = true;
         }
     }
-    else if(ActivityRange.size() > 0)
-        if(ActivityRange[ActivityRange.size()-1])
-            if(ActivityRange[ActivityRange.size()-1]->IsActive() && bIsActive)
-            {
-                ActivityRange[ActivityRange.size()-1]->EndEvent(CurrentFrame);
-                bIsActive = false;
-            }
+    else
+    {
+        _found_frames = 0;
+        if(_missing_frames++ == 0) _missing_since = CurrentFrame;
+        if(bIsActive && _missing_frames >= Config.ExitFrames)
+            CloseActivity(_missing_since);
+    }
+
+    // Species seen among the objects count towards the open event.
+    if(bIsActive)
+        for(auto& species : _species)
+            for(auto& name : species)
+                ActivityRange.back().AddSpeciesCandidate(name);
 
-    // If the event started and ended on the same frame, remove it (there's nothing really happening).
-    if(ActivityRange.size() > 0)
-        if(ActivityRange[ActivityRange.size()-1])
-            if(ActivityRange[ActivityRange.size()-1]->GetRange().first == ActivityRange[ActivityRange.size()-1]->GetRange().second)
+    // The moving objects wait in the detector's batch until it is full, or
+    // until the event ends.
+    if(bIsActive && _dnn)
+        for(int i = 0; i < 2; i++)
+            for(auto& box : GetBoundingBoxes(i))
             {
-                delete ActivityRange[ActivityRange.size()-1];
-                ActivityRange[ActivityRange.size()-1] = nullptr;
-                ActivityRange.resize(ActivityRange.size()-1);
+                Metrics::ScopedTimer timer(_metrics.get(), "detector");
+                _dnn->Add(_frame[i], box, CurrentFrame, i);
             }
+
+    // Holding on to the frames would keep their buffers from being reused.
+    for(int i = 0; i < 2; i++)
+        _frame[i].release();
+
+    // Frames skipped within a run come after its start, so only those before
+    // it are kept, and only until the run opens an event or ends.
+    if(bOpened)
+        BackfillActivity();
+    if(bIsActive || _found_frames == 0)
+        _skipped_before.clear();
+    _skipped.clear();
+}
+
+void Tracker::FilterEvents(std::vector<ActivityEvent>& events, const Settings& settings)
+{
+    // Merging comes first, so short bursts close together add up to one
+    // event long enough to keep.
+    std::vector<ActivityEvent> merged;
+    merged.reserve(events.size());
+    for(auto& event : events)
+    {
+        if(!merged.empty() && !merged.back().IsActive() &&
+           event.GetRange().first - merged.back().GetRange().second < settings.MergeGap)
+            merged.back().Merge(std::move(event));
+        else merged.push_back(std::move(event));
+    }
+
+    // Events which started and ended on the same frame are always dropped,
+    // as there's nothing really happening.
+    events.clear();
+    for(auto& event : merged)
+    {
+        auto range = event.GetRange();
+        if(range.second != -1 && range.second - range.first < std::max(settings.MinEventFrames, 1))
+            continue;
+
+        event.SetId(int(events.size() + 1));
+        events.push_back(std::move(event));
+    }
+}
+
+std::vector<cv::Rect> Tracker::GetBoundingBoxes(int camera) const
+{
+    std::vector<cv::Rect> boxes;
+    boxes.reserve(contours[camera].size());
+    for(auto& contour : contours[camera])
+        boxes.push_back(cv::boundingRect(contour));
+
+    return boxes;
+}
+
+void Tracker::SetMetrics(std::shared_ptr<Metrics> metrics)
+{
+    _metrics = metrics;
+}
+
+const DnnDetector* Tracker::GetDetector() const
+{
+    return _dnn.get();
+}
+
+cv::Ptr<cv::BackgroundSubtractor> Tracker::CreateSubtractor(const Settings& settings)
+{
+    switch(settings.Subtractor)
+    {
+        case Backend::MOG2:       return cv::createBackgroundSubtractorMOG2();
+        case Backend::GSOC:       return cv::bgsegm::createBackgroundSubtractorGSOC();
+        case Backend::LSBP:       return cv::bgsegm::createBackgroundSubtractorLSBP();
+        case Backend::CNT:        return cv::bgsegm::createBackgroundSubtractorCNT();
+        case Backend::FRAME_DIFF: return cv::makePtr<FrameDifference>(settings.FrameDiffThreshold);
+        case Backend::RUNNING_AVG:
+            return cv::makePtr<RunningAverage>(settings.RunningAvgThreshold, settings.RunningAvgShift);
+        case Backend::KNN:
+        default:                  return cv::createBackgroundSubtractorKNN();
+    }
+}
+
+Tracker::Backend Tracker::GetBackend(const std::string& name)
+{
+    for(auto backend : { Backend::KNN, Backend::MOG2, Backend::GSOC, Backend::LSBP, Backend::CNT,
+                          Backend::FRAME_DIFF, Backend::RUNNING_AVG })
+        if(GetBackendName(backend) == name)
+            return backend;
+
+    throw std::runtime_error("Unknown background subtraction backend \"" + name + "\"!");
+}
+
+std::string Tracker::GetBackendName(Backend backend)
+{
+    switch(backend)
+    {
+        case Backend::KNN:        return "KNN";
+        case Backend::MOG2:       return "MOG2";
+        case Backend::GSOC:       return "GSOC";
+        case Backend::LSBP:       return "LSBP";
+        case Backend::CNT:        return "CNT";
+        case Backend::FRAME_DIFF: return "FRAME_DIFF";
+        case Backend::RUNNING_AVG: return "RUNNING_AVG";
+    }
+    return "UNKNOWN";
 }
 
 void Tracker::GetCascades()
 {
-    // Get all YAML file names from directory.
-    std::vector<std::string> names;
-    for(auto name : names)
+    cascades.clear();
+    if(Config.CascadeDir.empty() || !cv::utils::fs::isDirectory(Config.CascadeDir))
+        return;
+
+    std::string dir = Config.CascadeDir.back() == '/' ? Config.CascadeDir : Config.CascadeDir + "/";
+    std::vector<cv::String> files;
+    for(auto pattern : { "*.xml", "*.yaml" })
+    {
+        std::vector<cv::String> matches;
+        cv::glob(dir + pattern, matches, false);
+        files.insert(files.end(), matches.begin(), matches.end());
+    }
+
+    for(auto& file : files)
+    {
+        auto cascade = cv::makePtr<cv::CascadeClassifier>();
+        if(cascade->load(file) && !cascade->empty())
+            cascades.insert(std::make_pair(FileStem(file), cascade));
+        else
+            std::cerr << " !> Could not load cascade \"" << file << "\"\n";
+    }
+}
+
+void Tracker::DetectSpecies(const cv::Mat& frame, int camera)
+{
+    _species[camera].clear();
+    if(cascades.empty() || contours[camera].empty())
+        return;
+
+    cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    cv::Size min_size(Config.CascadeMinSize, Config.CascadeMinSize);
+    for(auto& box : GetBoundingBoxes(camera))
     {
-        // Check if <name>.yaml exists.
-        if(false/* Add file exist check here */) cascades.insert(std::make_pair(0, new cv::CascadeClassifier(name + ".yaml")));
+        // Grow the box, as the mask rarely covers the whole fish.
+        int pad_x = (int)(box.width * Config.CascadePadding), pad_y = (int)(box.height * Config.CascadePadding);
+        cv::Rect roi = cv::Rect(box.x - pad_x, box.y - pad_y, box.width + 2 * pad_x, box.height + 2 * pad_y) & bounds;
+        if(roi.width < min_size.width || roi.height < min_size.height)
+            continue;
+
+        cv::Mat gray;
+        if(frame.channels() == 3)
+            cv::cvtColor(frame(roi), gray, cv::COLOR_BGR2GRAY);
+        else
+            gray = frame(roi).clone();
+        cv::equalizeHist(gray, gray);
+
+        for(auto& cascade : cascades)
+        {
+            std::vector<cv::Rect> objects;
+            cascade.second->detectMultiScale(gray, objects, 1.1, 3, 0, min_size);
+            for(size_t i = 0; i < objects.size(); i++)
+                _species[camera].push_back(cascade.first);
+        }
     }
+}
+
+const std::vector<std::string>& Tracker::GetSpeciesCandidates(int camera) const
+{
+    return _species[camera];
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+std::string FileStem(const std::string& path)
+{
+    size_t start = path.find_last_of("/\\");
+    std::string name = start == std::string::npos ? path : path.substr(start + 1);
+    return name.substr(0, name.find_last_of('.'));
 }
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "includes/TriangulationServer.h"
+#include "includes/Calibration.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+bool ParsePointPairs(const std::string&, std::vector<cv::Point2f>&, std::vector<cv::Point2f>&);
+bool WriteAll(int, const std::string&);
+std::string EscapeMessage(const std::string&);
+
+TriangulationServer::TriangulationServer(std::shared_ptr<Calibration> calib)
+    : _calib{calib}, _running{false}, _socket_fd{-1}
+{
+    if(!_calib)
+        throw std::runtime_error("Triangulation server needs a calibration!");
+}
+
+TriangulationServer::~TriangulationServer()
+{
+    Stop();
+}
+
+void TriangulationServer::Serve(std::istream& in, std::ostream& out) const
+{
+    std::string line;
+    while(std::getline(in, line))
+    {
+        if(line.empty()) continue;
+        out << HandleRequest(line) << '\n';
+        out.flush();
+    }
+}
+
+void TriangulationServer::Listen(const std::string& socket_path)
+{
+    sockaddr_un addr;
+    if(socket_path.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path \"" + socket_path + "\" is too long!");
+
+    _socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(_socket_fd < 0)
+        throw std::runtime_error("Could not create socket: " + std::string(strerror(errno)));
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // A stale socket from a previous run would make bind fail.
+    unlink(socket_path.c_str());
+    if(bind(_socket_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(_socket_fd, SOMAXCONN) < 0)
+    {
+        std::string err = strerror(errno);
+        Stop();
+        throw std::runtime_error("Could not listen on \"" + socket_path + "\": " + err);
+    }
+    _socket_path = socket_path;
+    _running = true;
+
+    std::cout << "=== Triangulation server listening on \"" << socket_path << "\" ===" << std::endl;
+    while(_running)
+    {
+        int client = accept(_socket_fd, nullptr, nullptr);
+        if(client < 0)
+        {
+            if(errno == EINTR) continue;
+            break;
+        }
+
+        // Connections accepted while stopping are closed right away, as Stop
+        // only waits for the ones it finds.
+        std::lock_guard<std::mutex> lock(_connections_mutex);
+        if(!_running)
+        {
+            close(client);
+            break;
+        }
+        CloseConnections(false);
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->fd = client;
+        connection->bDone = false;
+        connection->thread = std::thread(&TriangulationServer::ServeConnection, this, connection.get());
+        _connections.push_back(std::move(connection));
+    }
+}
+
+void TriangulationServer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_connections_mutex);
+        _running = false;
+        CloseConnections(true);
+    }
+    if(_socket_fd >= 0)
+    {
+        shutdown(_socket_fd, SHUT_RDWR);
+        close(_socket_fd);
+        _socket_fd = -1;
+    }
+    if(!_socket_path.empty())
+    {
+        unlink(_socket_path.c_str());
+        _socket_path.clear();
+    }
+}
+
+std::string TriangulationServer::HandleRequest(const std::string& request) const
+{
+    int64 start = cv::getTickCount();
+    std::string response = Triangulate(request);
+    long latency = (long)((cv::getTickCount() - start) * 1e6 / cv::getTickFrequency());
+    return "{" + response + ",\"latency_us\":" + std::to_string(latency) + "}";
+}
+
+std::string TriangulationServer::Triangulate(const std::string& request) const
+{
+    std::vector<cv::Point2f> left, right;
+    if(!ParsePointPairs(request, left, right))
+        return "\"Error\":\"Expected groups of four numbers: x_left y_left x_right y_right\"";
+
+    std::vector<cv::Point3f> world_points;
+    try
+    {
+        world_points = _calib->TriangulatePoints(left, right);
+    }
+    catch(const std::exception& e)
+    {
+        return "\"Error\":\"" + EscapeMessage(e.what()) + "\"";
+    }
+
+    std::string response = "\"Points\":[";
+    char buffer[96];
+    for(size_t i = 0; i < world_points.size(); i++)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s[%.6f,%.6f,%.6f]", i > 0 ? "," : "",
+                      world_points[i].x, world_points[i].y, world_points[i].z);
+        response += buffer;
+    }
+    response += "]";
+
+    return response;
+}
+
+void TriangulationServer::ServeConnection(Connection* connection) const
+{
+    int fd = connection->fd;
+    std::string pending;
+    char buffer[4096];
+    ssize_t n;
+    while((n = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        pending.append(buffer, n);
+
+        size_t start = 0, end;
+        while((end = pending.find('\n', start)) != std::string::npos)
+        {
+            std::string line = pending.substr(start, end - start);
+            start = end + 1;
+            if(line.empty() || line == "\r") continue;
+
+            if(!WriteAll(fd, HandleRequest(line) + '\n'))
+            {
+                connection->bDone = true;
+                return;
+            }
+        }
+        pending.erase(0, start);
+    }
+
+    // The socket is closed once the thread is joined, so Stop never shuts
+    // down a descriptor which was already reused.
+    connection->bDone = true;
+}
+
+void TriangulationServer::CloseConnections(bool bAll)
+{
+    for(auto it = _connections.begin(); it != _connections.end();)
+    {
+        Connection& connection = **it;
+        if(!bAll && !connection.bDone)
+        {
+            ++it;
+            continue;
+        }
+
+        // Shutting the socket down ends the blocking read of its thread.
+        shutdown(connection.fd, SHUT_RDWR);
+        if(connection.thread.joinable())
+            connection.thread.join();
+        close(connection.fd);
+        it = _connections.erase(it);
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+bool ParsePointPairs(const std::string& request, std::vector<cv::Point2f>& left, std::vector<cv::Point2f>& right)
+{
+    std::vector<float> values;
+    const char* c = request.c_str();
+    while(*c != '\0')
+    {
+        if(*c == ' ' || *c == ',' || *c == '\t' || *c == '\r')
+        {
+            c++;
+            continue;
+        }
+
+        char* end;
+        float value = std::strtof(c, &end);
+        if(end == c) return false;
+        values.push_back(value);
+        c = end;
+    }
+
+    if(values.empty() || values.size() % 4 != 0)
+        return false;
+
+    for(size_t i = 0; i < values.size(); i += 4)
+    {
+        left.push_back(cv::Point2f(values[i], values[i + 1]));
+        right.push_back(cv::Point2f(values[i + 2], values[i + 3]));
+    }
+    return true;
+}
+
+std::string EscapeMessage(const std::string& message)
+{
+    // Responses are one line each, so line breaks and other control
+    // characters become spaces.
+    std::string escaped;
+    for(char c : message)
+    {
+        if(c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += (unsigned char)c < 0x20 ? ' ' : c;
+    }
+    escaped.erase(escaped.find_last_not_of(' ') + 1);
+    return escaped;
+}
+
+bool WriteAll(int fd, const std::string& data)
+{
+    size_t written = 0;
+    while(written < data.size())
+    {
+        // MSG_NOSIGNAL keeps a client hanging up from killing the server with SIGPIPE.
+        ssize_t n = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            if(errno == EINTR) continue;
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
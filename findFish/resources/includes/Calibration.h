@@ -12,6 +12,8 @@
 
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include <map>
+#include <set>
 #include <mutex>
 
 enum CalibrationType { SINGLE, STEREO };
@@ -32,6 +34,12 @@ public:
 
         std::vector<std::vector<cv::Point3f>> object_points;
         std::vector<std::vector<cv::Point2f>> image_points[2];
+
+        // Views with a reprojection error (px) above this are pruned, while
+        // keeping at least min_views views.
+        double max_view_error = 1.0;
+        size_t min_views = 10;
+        int max_prune_iterations = 3;
     };
 
 private:
@@ -44,6 +52,7 @@ private:
         
         int n_image_pairs;
         std::vector<std::string> good_images;
+        std::vector<std::string> view_images[2];
         
         std::vector<std::vector<cv::Point3f>> object_points;
         std::vector<std::vector<cv::Point2f>> undistorted_points[2];
@@ -52,6 +61,34 @@ private:
         cv::Mat R1, R2, Q, P1, P2, E, F;
     };
 
+    /// Per-view reprojection errors and phase timings of a calibration run.
+    struct Report
+    {
+        struct View
+        {
+            std::string images[2];
+            double errors[2];
+            bool dropped;
+        };
+
+        struct Solve
+        {
+            std::string name;
+            double rms;
+            std::vector<View> views;
+        };
+
+        std::vector<std::pair<std::string, double>> timings;
+        std::vector<Solve> solves;
+    };
+
+    /// A cached calibration grid detection for a single image.
+    struct Detection
+    {
+        bool found;
+        std::vector<cv::Point2f> points;
+    };
+
 public:
     /// Construct a calibration object with Input, Type, and specifies an out directory.
     /// \param[in, out] in The input object containing necessary information for obtaining points.
@@ -76,9 +113,48 @@ public:
     /// \param[in] index Which camera results to use.
     void UndistortImage(cv::Mat&, int) const;
 
+    /// Resizes a given image to the calibrated size and undistorts it in one
+    /// pass, with maps which are computed once per camera and image size.
+    /// \param[in] img The image to undistort.
+    /// \param[out] dst The undistorted image, whose buffer is reused if it
+    ///                 already has the calibrated size.
+    /// \param[in] index Which camera results to use.
+    void UndistortImage(const cv::Mat& img, cv::Mat& dst, int index) const;
+
+    /// Maps points from an undistorted frame onto the rectified image plane of
+    /// a camera, where matching points share the same row in both cameras.
+    /// \param[in] points The points in undistorted frame coordinates.
+    /// \param[in] index Which camera results to use.
+    /// \return The points in rectified coordinates.
+    std::vector<cv::Point2f> RectifyPoints(const std::vector<cv::Point2f>& points, int index) const;
+
+    /// Builds the maps which rectify an undistorted frame of a camera.
+    /// \param[in] index Which camera results to use.
+    /// \param[out] map1 The first remap map (fixed point coordinates).
+    /// \param[out] map2 The second remap map (interpolation table).
+    void GetRectifyMaps(int index, cv::Mat& map1, cv::Mat& map2) const;
+
+    /// Reprojects a rectified left image point and its disparity into 3D.
+    /// \param[in] point The point on the rectified left image plane.
+    /// \param[in] disparity The disparity of the point in pixels.
+    /// \return The real world coordinate of the point.
+    cv::Point3f ReprojectDisparity(const cv::Point2f& point, float disparity) const;
+
+    /// Checks whether the stereo rectification results are available.
+    /// \return True if both cameras and their projections are calibrated.
+    bool IsStereoCalibrated() const;
+
     /// Triangulates undistorted image points into real world 3D coordinates.
     void TriangulatePoints();
 
+    /// Triangulates matching left and right image points into real world 3D
+    /// coordinates, without touching the filesystem.
+    /// \param[in] left The image points from the left camera.
+    /// \param[in] right The matching image points from the right camera.
+    /// \return The triangulated world points, one per pair of image points.
+    std::vector<cv::Point3f> TriangulatePoints(const std::vector<cv::Point2f>& left,
+                                               const std::vector<cv::Point2f>& right) const;
+
 private:
     /// Runs individual calibration for each camera.
     void SingleCalibrate();
@@ -86,9 +162,56 @@ private:
     /// Runs stereo calibration on the two previously calibrated cameras.
     void StereoCalibrate();
 
+    /// Calibrates a single camera, pruning outlier views and re-solving until
+    /// every remaining view is below the error threshold.
+    /// \param[in] index The camera to calibrate.
+    /// \param[in] flags The calibration flags for the first solve.
+    /// \return The RMS reprojection error of the final solve.
+    double CalibrateCamera(int index, int flags);
+
+    /// Picks the views to prune from a solve.
+    /// \param[in] errors The per-view errors, one column per camera.
+    /// \param[in] iteration How many times the views were already pruned.
+    /// \return Whether each view should be dropped.
+    std::vector<bool> FindOutlierViews(const cv::Mat& errors, int iteration) const;
+
+    /// Removes views from a camera, or from both cameras for stereo.
+    /// \param[in] index The camera to remove the views from.
+    /// \param[in] drop Whether each view should be dropped.
+    void RemoveViews(int index, const std::vector<bool>& drop);
+
+    /// Records the time taken by a calibration phase.
+    /// \param[in] phase The name of the phase.
+    /// \param[in] start The tick count when the phase started.
+    void AddTiming(const std::string& phase, int64 start);
+
+    /// Writes the calibration report as JSON to the output directory.
+    void WriteReport() const;
+
+    /// Builds the object points of a single view of the calibration grid.
+    /// \return The grid points in millimetres.
+    std::vector<cv::Point3f> GridPoints() const;
+
     /// Finds key image points, such as a calibration grid.
     void GetImagePoints();
 
+    /// Finds the calibration grid in an image, reusing the cached detection
+    /// if the image has been seen before.
+    /// \param[in] image The path of the image.
+    /// \param[out] points The grid points found in the image.
+    /// \return True if the grid was found.
+    bool FindGrid(const std::string& image, std::vector<cv::Point2f>& points);
+
+    /// Reads the grid detections cached by previous calibrations.
+    void ReadDetectionCache();
+
+    /// Writes the grid detections of the current images to the cache.
+    void WriteDetectionCache() const;
+
+    /// Reads the results of a previous calibration to warm start the solvers.
+    /// \param[out] previous The previous results, left empty if none match.
+    void ReadPreviousResults(Result& previous) const;
+
     /// Undistorts image points using stereo calibration results.
     void UndistortPoints();
 
@@ -97,8 +220,24 @@ public:
 
 private:
     Result _result;
+    Report _report;
+
+    /// Cached grid detections, keyed by a hash of the image contents.
+    std::map<std::string, Detection> _detections;
+    std::set<std::string> _used_detections;
 
     std::recursive_mutex _mutex;
+
+    /// Undistortion maps of each camera, for images of the source size and
+    /// the calibration they were computed from.
+    struct UndistortMaps
+    {
+        cv::Size source;
+        cv::Mat camera_matrix, dist_coeffs;
+        cv::Mat map1, map2;
+    };
+    mutable UndistortMaps _undistort[2];
+    mutable std::mutex _undistort_mutex;
     
     std::string _outfile_name;
     std::string _out_dir;
@@ -0,0 +1,114 @@
+/// \date October 16, 2026
+///
+/// A learned fish detector which runs an SSD-style DetectionOutput network
+/// through OpenCV's dnn module on the CPU. The detector only looks at the
+/// regions where motion was found, and queues those regions until it has a
+/// full batch, so that a single forward pass covers the objects of several
+/// frames.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+#include <string>
+#include <vector>
+
+/// A single object found by the detector.
+struct Detection
+{
+    int frame;
+    int camera;
+    int label;
+    float score;
+
+    // The box in the coordinates of the full frame.
+    cv::Rect box;
+};
+
+/// Batches motion regions through a dnn network and collects its detections.
+class DnnDetector
+{
+public:
+    /// Nested wrapper class for settings pertaining to the network.
+    struct Settings
+    {
+        // The network weights (.onnx or .caffemodel), and the Caffe prototxt
+        // if there is one. The network has to end in an SSD DetectionOutput
+        // layer, as other output layouts cannot be read.
+        std::string Model = "models/fish_detector.onnx";
+        std::string ConfigFile = "";
+
+        // Every region is resized to InputSize before the forward pass.
+        cv::Size InputSize = cv::Size(300, 300);
+        double Scale = 1.0 / 255.0;
+        cv::Scalar Mean = cv::Scalar(0, 0, 0);
+        bool bSwapRB = true;
+
+        // Detections scoring below this are discarded.
+        float ConfidenceThreshold = 0.5f;
+
+        // Number of regions, from any number of frames, per forward pass.
+        int BatchSize = 16;
+
+        // Regions are grown by this fraction of their size on every side.
+        float Padding = 0.25f;
+    };
+
+    /// Time spent in every stage of the detector, in milliseconds.
+    struct Timings
+    {
+        double preprocess_ms = 0.0;
+        double forward_ms = 0.0;
+        double postprocess_ms = 0.0;
+        int batches = 0;
+        int regions = 0;
+    };
+
+public:
+    /// Loads the network for the CPU.
+    /// \param[in] settings The settings for the detector.
+    DnnDetector(Settings settings);
+
+    /// Queues a motion region of a frame, and runs the network once a full
+    /// batch has been queued. Throws if the first batch shows the network
+    /// does not output SSD detections.
+    /// \param[in] frame The image/frame the region was found in.
+    /// \param[in] box The bounding box of the moving object.
+    /// \param[in] frame_num The number of the frame.
+    /// \param[in] camera The index of the camera the frame came from.
+    void Add(const cv::Mat& frame, const cv::Rect& box, int frame_num, int camera = 0);
+
+    /// Runs the network on any regions still queued, and hands over every
+    /// detection found since the last flush.
+    /// \return The detections, in the order their regions were queued.
+    std::vector<Detection> Flush();
+
+    /// Gets the time spent in every stage so far.
+    /// \return The accumulated timings.
+    const Timings& GetTimings() const;
+
+public:
+    /// Settings for the detector.
+    Settings Config;
+
+private:
+    /// Runs a forward pass over the queued regions.
+    void RunBatch();
+
+    /// A queued region, already resized to the network's input size.
+    struct Region
+    {
+        int frame;
+        int camera;
+        cv::Rect roi;
+        cv::Mat image;
+    };
+
+private:
+    cv::dnn::Net _net;
+    std::vector<Region> _pending;
+    std::vector<Detection> _detections;
+    Timings _timings;
+    bool _output_checked;
+};
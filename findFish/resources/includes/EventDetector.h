@@ -13,13 +13,17 @@
 #include <opencv2/objdetect.hpp>
 #include <opencv2/imgcodecs.hpp>
 
+#include "DnnDetector.h"
+#include "ObjectTracker.h"
+
 #include <map>
 #include <string>
-#include <mutex>
+#include <vector>
 
 class JSON;
 
-/// Abstract Base class for defining an event.
+/// Abstract Base class for defining an event. Events are not locked, so each
+/// one should only be changed by a single thread at a time.
 class EventBuilder
 {
  public:
@@ -29,6 +33,12 @@ class EventBuilder
   /// Default destructor.
   virtual ~EventBuilder();
 
+  /// Events are plain values, which are copied and moved with their fields.
+  EventBuilder(const EventBuilder&) = default;
+  EventBuilder(EventBuilder&&) = default;
+  EventBuilder& operator=(const EventBuilder&) = default;
+  EventBuilder& operator=(EventBuilder&&) = default;
+
   /// Check frame for some sort of event.
   /// \param[in, out] The current frame.
   virtual void CheckFrame(cv::Mat& frame, int&) = 0;
@@ -41,19 +51,18 @@ class EventBuilder
   /// \param[in, out] frame The frame number that marks the end of the event.
   virtual void EndEvent(int& frame) = 0;
 
-  /// Returns the event as a JSON object.
-  /// \return The event formatted into a JSON object.
-  const JSON GetAsJSON();
+  /// Formats the event as a JSON object. Events only keep plain fields, so
+  /// the JSON is built on every call and is meant for writing out results.
+  /// \return The event formatted into a JSON object, which is unnamed and
+  ///         empty until the event has ended.
+  virtual JSON GetAsJSON() const = 0;
 
   /// Get the range of the event frames.
   /// \returns The start and end frames as a pair.
   std::pair<int, int> GetRange() const;
 
  protected:
-  std::mutex _mutex;
-  cv::Mat _frame;
   int _start_frame, _end_frame;
-  std::unique_ptr<JSON> _json_object;
 };
 
 /// Defines an event which attempts to detect a QR code from a frame.
@@ -82,12 +91,67 @@ class QREvent : public EventBuilder
   /// Returns whether or not a QR code was found.
   /// \return If the QR code was detected or not.
   const bool DetectedQR() const;
- 
- private:
+
+  /// Formats the QR code as the "Event_QRCode" object, with its frame and
+  /// the values of its Geo URI.
+  /// \return The event formatted into a JSON object.
+  virtual JSON GetAsJSON() const override;
+
   /// Parses the QR code URL for a Geo URI.
+  /// \param[in] uri The URL decoded from the QR code.
   /// \return All the key-value pairs found in the URL.
-  std::map<std::string, std::string> GetGeoURIValues(std::string& uri) const;
+  static std::map<std::string, std::string> GetGeoURIValues(std::string uri);
 
+ private:
+  std::string url_;
+};
+
+/// The plain fields of an activity event, without its tracks and detections.
+struct ActivitySummary
+{
+  int id = 0;
+  int frame_start = -1;
+  int frame_end = -1;
+
+  // Median of the length estimates, in millimetres, which is only valid when
+  // there were samples, and the number of depth estimates of single objects.
+  float length_mm = 0.f;
+  size_t length_samples = 0;
+  size_t depth_samples = 0;
+
+  // Objects tracked by the busier camera, and the area covered by the tracked
+  // boxes of each camera.
+  size_t n_objects = 0;
+  cv::Rect bounds[2];
+};
+
+/// The estimated depth of a single object in a single frame.
+struct ObjectDepth
+{
+  int frame;
+
+  // The box of the object in the left camera, as the motion tracker found it.
+  cv::Rect box;
+  float depth_mm;
+};
+
+/// Small previews of an activity event.
+struct EventThumbnails
+{
+  // Evenly spaced frame pairs of the event side by side, and their frames.
+  std::vector<uchar> strip;
+  std::vector<int> strip_frames;
+
+  // A close up of the largest object seen during the event.
+  std::vector<uchar> keyframe;
+  int keyframe_frame = -1;
+  int keyframe_camera = -1;
+  cv::Rect box;
+
+  // Where the images were written, once they are, after which the encoded
+  // images are no longer kept.
+  std::string strip_file;
+  std::string keyframe_file;
 };
 
 /// Defines an event in which there was activity of some sort.
@@ -104,6 +168,11 @@ class ActivityEvent : public EventBuilder
   /// Default destructor for the class.
   virtual ~ActivityEvent() {};
 
+  ActivityEvent(const ActivityEvent&) = default;
+  ActivityEvent(ActivityEvent&&) = default;
+  ActivityEvent& operator=(const ActivityEvent&) = default;
+  ActivityEvent& operator=(ActivityEvent&&) = default;
+
   /// Check frame for some sort of event.
   /// \param[in, out] frame The frame in which to check.
   /// \param[in, out] The current frame.
@@ -117,10 +186,74 @@ class ActivityEvent : public EventBuilder
   /// param[in, out] frame The ending frame of the event.
   virtual void EndEvent(int&) override;
 
+  /// Formats the event as an "Event_Activity_<id>" object.
+  /// \return The event formatted into a JSON object.
+  virtual JSON GetAsJSON() const override;
+
+  /// Summarizes the measurements and tracks of the event.
+  /// \return The plain fields of the event.
+  ActivitySummary Summary() const;
+
   /// Checks whether or not the event is still happening.
   /// \return The running state of the event.
   bool IsActive() const;
 
+  /// Moves the start of the event back to an earlier frame, for events which
+  /// were only noticed some frames after they started.
+  /// \param[in] frame The real starting frame of the event.
+  void BackdateStart(int frame);
+
+  /// Records a length estimate of an object seen during the event.
+  /// \param[in] length The estimated length in millimetres.
+  void AddMeasurement(float length);
+
+  /// Records a depth estimate of an object seen during the event. It is
+  /// reported with the track of the left camera the object belongs to, if
+  /// any, and on its own otherwise.
+  /// \param[in] frame The frame the object was seen in.
+  /// \param[in] box The box of the object in the left camera.
+  /// \param[in] depth The estimated distance from the cameras in millimetres.
+  void AddDepth(int frame, const cv::Rect& box, float depth);
+
+  /// Records a species detected among the objects of the event.
+  /// \param[in] species The name of the species.
+  void AddSpeciesCandidate(const std::string& species);
+
+  /// Records the track of an object seen during the event.
+  /// \param[in] track The track of the object.
+  void AddTrack(const ObjectTrack& track);
+
+  /// Records an object found by the learned detector during the event.
+  /// \param[in] detection The detection box and score.
+  void AddDetection(const Detection& detection);
+
+  /// Sets the previews of the event.
+  /// \param[in] thumbnails The encoded or written thumbnails.
+  void SetThumbnails(EventThumbnails thumbnails);
+
+  /// Gets the previews of the event.
+  /// \return The thumbnails, which are empty unless they were set.
+  const EventThumbnails& GetThumbnails() const;
+
+  /// Absorbs a later event, extending this one to its end and keeping the
+  /// samples, tracks and detections of both.
+  /// \param[in, out] later The event to absorb, which is left empty.
+  void Merge(ActivityEvent&& later);
+
+  /// Gets the unique ID of the event.
+  /// \return The ID the event is named after.
+  int GetId() const;
+
+  /// Changes the ID of the event, e.g. after other events were removed.
+  /// \param[in] id The new unique ID.
+  void SetId(int id);
+
  private:
    int id_;
+   std::vector<float> lengths_;
+   std::vector<ObjectDepth> depths_;
+   std::vector<ObjectTrack> tracks_;
+   std::vector<Detection> detections_;
+   std::map<std::string, int> species_;
+   EventThumbnails thumbnails_;
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+/// \date October 16, 2026
+///
+/// Small helpers for identifying files by their contents, so that work done on
+/// a file (such as finding a calibration grid) can be cached and reused for as
+/// long as the file does not change, regardless of its name or location.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// Hashes the full contents of a file with 64 bit FNV-1a.
+/// \param[in] path The path of the file to hash.
+/// \return The hash of the file, or 0 if it could not be read.
+uint64_t HashFile(const std::string& path);
+
+/// Fingerprints a file from its size and the bytes at its start and end,
+/// which is enough to tell videos apart without reading them in full.
+/// \param[in] path The path of the file to fingerprint.
+/// \return The fingerprint of the file, or 0 if it could not be read.
+uint64_t FingerprintFile(const std::string& path);
+
+/// Formats a hash as a fixed width hexadecimal string.
+/// \param[in] hash The hash to format.
+/// \return The hash as 16 hexadecimal characters.
+std::string HashToString(uint64_t hash);
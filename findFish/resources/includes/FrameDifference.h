@@ -0,0 +1,33 @@
+/// \date October 16, 2026
+///
+/// The cheapest possible motion detector: every pixel which changed by more
+/// than a threshold since the previous frame is foreground. There is no
+/// background model to learn, so it reacts immediately, but slow moving or
+/// uniformly coloured objects only show up along their edges.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/// A background subtractor which compares each frame to the one before it.
+class FrameDifference : public cv::BackgroundSubtractor
+{
+public:
+    /// Constructs a frame differencer.
+    /// \param[in] threshold The minimum grey level change of a moving pixel.
+    FrameDifference(int threshold = 25);
+
+    /// Computes the foreground mask against the previous frame.
+    /// \param[in] image The next frame.
+    /// \param[out] fgmask The mask, 255 where the frame changed, 0 elsewhere.
+    /// \param[in] learningRate If 0, the frame does not replace the background.
+    void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRate = -1) override;
+
+    /// Gets the frame the next frame will be compared to.
+    /// \param[out] backgroundImage The previous greyscale frame.
+    void getBackgroundImage(cv::OutputArray backgroundImage) const override;
+
+private:
+    int _threshold;
+    cv::Mat _previous;
+};
@@ -10,6 +10,7 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 
 /// A JSON builder which takes in values as strings an formats them into
@@ -44,6 +45,12 @@ class JSON
    /// \parampin] Value The value associated with the key.
    void AddKeyValue(std::string Key, std::string Value);
 
+   /// Creates a new key-value pair whose value is already valid JSON, such as
+   /// an array, and appends it to the object without quoting it.
+   /// \param[in] Key The value of the key.
+   /// \param[in] Value The JSON value associated with the key.
+   void AddRawValue(std::string Key, std::string Value);
+
    /// Adds a premade JSON Object to this JSON.
    /// \param[in, out] obj The JSON object to be appended.
    void AddObject(JSON& obj);
@@ -75,6 +82,7 @@ class JSON
     std::string _json_string;
     std::string _name;
     std::map<std::string, std::string> _key_val_pairs;
+    std::set<std::string> _raw_keys;
     std::vector<JSON> _subobjects;
 };
 
@@ -0,0 +1,116 @@
+/// \date October 16, 2026
+///
+/// Keeps processing under a target resident memory. The budget left after
+/// what is already in use is split between the frame pairs held while idle,
+/// a pool of reusable decoded frames, and OpenCV's worker threads, all in
+/// units of frames. While processing, resident memory is checked every few
+/// frames, and the plan is halved whenever it goes over the budget.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// How the memory of a run is split up.
+struct MemoryPlan
+{
+    // Frame pairs held while idle, frames kept for reuse, and worker threads.
+    int queue_depth = 0;
+    int pool_frames = 0;
+    int threads = 1;
+
+    // Whether the budget covers at least one frame pair in flight.
+    bool fits = true;
+};
+
+/// Sizes the buffers and workers of a run to a memory budget.
+class MemoryBudget
+{
+public:
+    /// Nested wrapper class for settings pertaining to the memory budget.
+    struct Settings
+    {
+        // Target resident memory in megabytes, 0 for no limit.
+        size_t BudgetMB = 0;
+
+        // Frame sized buffers each frame pair needs while it is decoded,
+        // undistorted, tracked, concatenated and encoded, and the scratch
+        // buffers of each worker thread.
+        int WorkingFrames = 12;
+        int ThreadFrames = 1;
+
+        // Resident memory is checked, and the stages of a frame sampled, every
+        // SampleInterval frames.
+        int SampleInterval = 30;
+    };
+
+public:
+    /// Constructor which takes in some settings object.
+    /// \param[in] settings The settings for the budget.
+    MemoryBudget(Settings settings);
+
+    /// Splits the budget left after the memory already in use.
+    /// \param[in] frame_size The size of the decoded frames.
+    /// \param[in] max_depth The most frame pairs worth holding while idle.
+    /// \param[in] max_threads The most worker threads worth running.
+    /// \param[in] in_use The resident memory before processing, in bytes.
+    /// \return The plan, which is as large as allowed without a budget.
+    MemoryPlan Plan(cv::Size frame_size, int max_depth, int max_threads, size_t in_use) const;
+
+    /// Halves a plan if resident memory is over the budget.
+    /// \param[in, out] plan The plan to shrink.
+    /// \param[in] rss The resident memory, in bytes.
+    /// \return True if the plan was shrunk.
+    bool Enforce(MemoryPlan& plan, size_t rss) const;
+
+    /// Checks whether there is a budget at all.
+    /// \return True if BudgetMB is set.
+    bool IsLimited() const;
+
+    /// Gets the resident memory of the process.
+    /// \return The resident memory in bytes, or 0 where it cannot be read.
+    static size_t ResidentBytes();
+
+    /// Gets the highest resident memory of the process so far.
+    /// \return The peak resident memory in bytes, or 0 where it cannot be read.
+    static size_t PeakResidentBytes();
+
+public:
+    /// Settings for the budget.
+    Settings Config;
+};
+
+/// A bounded pool of decoded frames, so reading a frame reuses the buffer of
+/// one which is done with instead of allocating a new one.
+class FramePool
+{
+public:
+    /// Constructs an empty pool.
+    /// \param[in] capacity The most frames kept for reuse.
+    FramePool(size_t capacity);
+
+    /// Gets a frame, reusing a pooled one if there is any. The frame returns
+    /// to the pool once nothing points to it anymore.
+    /// \return The frame, which may still hold an old image.
+    std::shared_ptr<cv::Mat> Acquire();
+
+    /// Changes how many frames are kept, freeing any above it.
+    /// \param[in] capacity The most frames kept for reuse.
+    void SetCapacity(size_t capacity);
+
+    /// Gets how many frames are waiting to be reused.
+    /// \return The number of pooled frames.
+    size_t Available() const;
+
+private:
+    struct Shared
+    {
+        std::mutex mutex;
+        std::vector<cv::Mat> frames;
+        size_t capacity;
+    };
+    std::shared_ptr<Shared> _shared;
+};
@@ -0,0 +1,141 @@
+/// \date October 16, 2026
+///
+/// Instrumentation for the processing pipeline. Every stage records its
+/// latency into a histogram with fixed, roughly logarithmic buckets, and
+/// counters keep track of frames and events. The results are written as a JSON
+/// summary at the end of a run, and can be streamed while it is still going.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "JsonBuilder.h"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Collects per-stage latencies and counters.
+class Metrics
+{
+public:
+    /// The latencies recorded for a single stage.
+    struct Histogram
+    {
+        // One count per bucket bound, plus one for anything slower.
+        std::vector<long> buckets;
+        long count = 0;
+        double total_ms = 0.0;
+        double min_ms = 0.0;
+        double max_ms = 0.0;
+
+        // The highest resident memory of the whole process seen right after
+        // the stage, in bytes, which is only sampled while memory sampling is
+        // on. It is not what the stage itself used.
+        size_t process_rss = 0;
+
+        /// Records a single latency.
+        /// \param[in] ms The latency in milliseconds.
+        void Add(double ms);
+
+        /// Gets the average latency.
+        /// \return The mean in milliseconds, or 0 without samples.
+        double Mean() const;
+
+        /// Estimates a percentile from the buckets.
+        /// \param[in] p The percentile, between 0 and 1.
+        /// \return The upper bound of the bucket holding the percentile, capped
+        ///         at the slowest latency seen.
+        double Percentile(double p) const;
+    };
+
+    /// Times a stage for as long as it is in scope. A null Metrics makes the
+    /// timer do nothing, so stages can be timed unconditionally.
+    class ScopedTimer
+    {
+    public:
+        /// Starts timing a stage.
+        /// \param[in] metrics The metrics to record into, or null.
+        /// \param[in] stage The name of the stage.
+        ScopedTimer(Metrics* metrics, const char* stage);
+
+        /// Records the time since construction, and the resident memory while
+        /// memory sampling is on.
+        ~ScopedTimer();
+
+    private:
+        Metrics* _metrics;
+        const char* _stage;
+        int64 _start;
+    };
+
+public:
+    /// Records a latency for a stage.
+    /// \param[in] stage The name of the stage, e.g. "decode".
+    /// \param[in] ms The latency in milliseconds.
+    void AddSample(const std::string& stage, double ms);
+
+    /// Records the resident memory of the process after a stage, keeping the
+    /// highest.
+    /// \param[in] stage The name of the stage, e.g. "decode".
+    /// \param[in] bytes The resident memory of the process in bytes.
+    void AddMemorySample(const std::string& stage, size_t bytes);
+
+    /// Turns the sampling of resident memory after every timed stage on or
+    /// off. It reads /proc, so it is only meant for some of the frames.
+    /// \param[in] bSample Whether to sample memory.
+    void SetMemorySampling(bool bSample);
+
+    /// Checks whether timed stages sample resident memory.
+    /// \return True while memory sampling is on.
+    bool IsSamplingMemory() const;
+
+    /// Increments a counter.
+    /// \param[in] counter The name of the counter, e.g. "frames_empty".
+    /// \param[in] n The amount to add.
+    void Increment(const std::string& counter, long n = 1);
+
+    /// Gets the value of a counter.
+    /// \param[in] counter The name of the counter.
+    /// \return The value, or 0 for counters never incremented.
+    long GetCounter(const std::string& counter) const;
+
+    /// Sets a gauge, which unlike a counter holds the last value set, e.g. a
+    /// measurement of the process rather than a count of what happened.
+    /// \param[in] gauge The name of the gauge, e.g. "process_rss_peak_mb".
+    /// \param[in] value The value.
+    void SetGauge(const std::string& gauge, double value);
+
+    /// Gets the value of a gauge.
+    /// \param[in] gauge The name of the gauge.
+    /// \return The value, or 0 for gauges never set.
+    double GetGauge(const std::string& gauge) const;
+
+    /// Gets the histogram of a stage.
+    /// \param[in] stage The name of the stage.
+    /// \return The histogram, or null for stages never timed.
+    const Histogram* GetStage(const std::string& stage) const;
+
+    /// Builds a summary of every stage, counter and gauge.
+    /// \return The summary as a JSON object named "Metrics".
+    JSON ToJSON() const;
+
+    /// Writes the summary to a file.
+    /// \param[in] file The path of the JSON file.
+    void Write(const std::string& file) const;
+
+    /// Writes the summary as a single line, e.g. for following a run live.
+    /// \param[in, out] out The stream to write to.
+    void Stream(std::ostream& out) const;
+
+    /// Gets the upper bounds of the histogram buckets.
+    /// \return The bounds in milliseconds, in increasing order.
+    static const std::vector<double>& BucketBounds();
+
+private:
+    std::map<std::string, Histogram> _stages;
+    std::map<std::string, long> _counters;
+    std::map<std::string, double> _gauges;
+    bool _sample_memory = false;
+};
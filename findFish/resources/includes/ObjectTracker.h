@@ -0,0 +1,100 @@
+/// \date October 16, 2026
+///
+/// A lightweight multi-object tracker which follows the bounding boxes found
+/// by the motion tracker from frame to frame. Every track carries a constant
+/// velocity Kalman filter predicting where its object will be next, and new
+/// boxes are greedily matched to the predictions with the highest overlap.
+/// Tracks keep a stable ID for as long as their object is seen, which lets a
+/// single activity event tell apart the fish swimming through it.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/video.hpp>
+
+#include <utility>
+#include <vector>
+
+/// The trajectory of a single object through consecutive frames.
+struct ObjectTrack
+{
+    int id;
+    int camera;
+    int frame_start;
+    int frame_end;
+
+    // The box of the object in every frame it was seen in.
+    std::vector<std::pair<int, cv::Rect>> boxes;
+};
+
+/// Associates bounding boxes across frames into object tracks.
+class ObjectTracker
+{
+public:
+    /// Nested wrapper class for settings pertaining to object tracking.
+    struct Settings
+    {
+        // Minimum overlap of a box with a prediction to continue its track.
+        float MinIoU = 0.2f;
+
+        // Frames a track may go unseen before it is finished.
+        int MaxMissed = 5;
+
+        // Frames an object must be seen in to count as a real track.
+        int MinHits = 3;
+    };
+
+public:
+    /// Constructs a tracker with the default settings.
+    ObjectTracker();
+
+    /// Constructs a tracker for the boxes of a single camera.
+    /// \param[in] settings The settings for tracking.
+    /// \param[in] camera The index of the camera the boxes come from.
+    ObjectTracker(Settings settings, int camera = 0);
+
+    /// Matches the boxes of a new frame to the current tracks, starting new
+    /// tracks for unmatched boxes and finishing tracks unseen for too long.
+    /// \param[in] boxes The bounding boxes found in the frame.
+    /// \param[in] frame The frame number.
+    void Update(const std::vector<cv::Rect>& boxes, int frame);
+
+    /// Finishes every track and hands over all confirmed tracks.
+    /// \return The tracks seen in at least MinHits frames, oldest first.
+    std::vector<ObjectTrack> Flush();
+
+    /// Gets the number of tracks currently being followed.
+    /// \return The number of open tracks.
+    size_t ActiveTracks() const;
+
+public:
+    /// Settings for the tracker.
+    Settings Config;
+
+private:
+    /// The state of an open track.
+    struct TrackState
+    {
+        ObjectTrack track;
+        cv::KalmanFilter filter;
+        cv::Rect2f prediction;
+        int predicted_frame;
+        int hits;
+        int missed;
+    };
+
+    /// Starts a new track from a box.
+    /// \param[in] box The first box of the track.
+    /// \param[in] frame The frame number.
+    void StartTrack(const cv::Rect& box, int frame);
+
+    /// Moves a track to the finished tracks, if it was seen often enough.
+    /// \param[in] state The track to finish.
+    void FinishTrack(TrackState& state);
+
+private:
+    int _camera;
+    int _next_id;
+    std::vector<TrackState> _tracks;
+    std::vector<ObjectTrack> _finished;
+};
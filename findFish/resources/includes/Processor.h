@@ -15,11 +15,22 @@
 namespace cv {
   class Mat;
   class VideoCapture;
+  template<typename _Tp> class Rect_;
+  typedef Rect_<int> Rect;
+  template<typename _Tp> class Size_;
+  typedef Size_<int> Size;
 }
 class Tracker;
 class JSON;
 class Video;
 class Calibration;
+class StereoMeasure;
+class Disparity;
+class Metrics;
+class ThumbnailBuilder;
+class ActivityEvent;
+class FramePool;
+struct SyncResult;
 
 /// \brief Goes through two videos to find events and concatenate them together.
 ///
@@ -28,9 +39,82 @@ class Calibration;
 /// events from the video.
 class Processor
 {
+public:
+  /// Nested wrapper class for settings pertaining to video processing.
+  struct Settings
+  {
+    // Automatically measure objects seen by both cameras during events.
+    bool bMeasureObjects = true;
+
+    // Estimate object depth with block matching on the measured objects.
+    bool bEstimateDepth = false;
+    bool bFilterDepth = false;
+
+    // Name of the background subtraction backend used to detect activity.
+    std::string Subtractor = "KNN";
+
+    // While there is no activity, only every IdleStride-th frame is tracked.
+    // Events are still backdated to the first frame with activity.
+    int IdleStride = 1;
+
+    // Events only start or end once objects have been there, or been gone,
+    // for EventEnterFrames or EventExitFrames tracked frames. Events fewer
+    // than EventMergeGap frames apart are merged, and events shorter than
+    // MinEventFrames are dropped.
+    int EventEnterFrames = 2;
+    int EventExitFrames = 3;
+    int EventMergeGap = 15;
+    int MinEventFrames = 5;
+
+    // SSD-style DetectionOutput network for the learned fish detector, which
+    // is disabled when empty. Caffe models also need their prototxt as
+    // DetectorConfig.
+    std::string DetectorModel = "";
+    std::string DetectorConfig = "";
+
+    // Only this many frames at the start of each video are searched for the
+    // QR code, and the offset is refined with the brightness of the videos.
+    int SyncSearchFrames = 900;
+    bool bRefineSync = true;
+
+    // Sync results are cached here by the fingerprints of both videos, so
+    // reprocessing a pair seeks straight to its sync point. Empty disables it.
+    std::string SyncCacheFile = "static/sync_cache.yaml";
+
+    // A keyframe strip and a close up of the largest object of every event
+    // are saved to ThumbnailDir, and listed in the events JSON.
+    bool bSaveThumbnails = true;
+    std::string ThumbnailDir = "static/thumbnails/";
+
+    // When ProxyWidth is set, reviewers get a proxy of the combined video that
+    // wide in place of the full resolution video, which is kept in ArchiveDir
+    // and only uploaded once the server has an archive folder. Both are
+    // encoded in the same pass. By default only the full video is written.
+    int ProxyWidth = 0;
+    std::string ArchiveDir = "static/archive_videos/";
+
+    // While a proxy is written, the full video can instead be split into
+    // segments of SegmentSeconds in SegmentDir, listed in a manifest, so the
+    // finished ones can be uploaded during processing. 0 keeps one file.
+    int SegmentSeconds = 0;
+    std::string SegmentDir = "static/segments/";
+
+    // Resident memory is kept under MemoryBudgetMB, if set, by sizing the
+    // frames held while idle, the frame pool and the worker threads to fit,
+    // and shrinking them if it is still exceeded. The peak resident memory
+    // after each stage is sampled into the metrics either way.
+    size_t MemoryBudgetMB = 0;
+
+    // Per-stage latencies and counters are written to MetricsDir for every
+    // pair, and streamed to stdout every MetricsStreamInterval frames if set.
+    std::string MetricsDir = "static/metrics/";
+    int MetricsStreamInterval = 0;
+  };
+
 public:
   Processor();
   Processor(std::string, std::string);
+  Processor(std::string, std::string, Settings);
   ~Processor();
 
   /// Takes two videos and goes through each of them, finding activity events
@@ -44,28 +128,66 @@ public:
   /// \param[in] calib_file The file which contains the stereo calibration data.
   void TriangulatePoints(std::string points_file, std::string calib_file);
 
+  /// Gets the size of the proxy of a video, keeping its aspect ratio with
+  /// even dimensions, as most codecs need.
+  /// \param[in] canvas The size of the full video.
+  /// \param[in] width The width of the proxy.
+  /// \return The size of the proxy, or an empty size if it would not be
+  ///         smaller than the video.
+  static cv::Size GetProxySize(cv::Size canvas, int width);
+
 private:
   /// Undistorts the given frame using calibration data for camera at index.
-  /// \param[in, out] frame The frame to undistort.
+  /// \param[in] frame The frame to undistort.
+  /// \param[out] undistorted The undistorted frame, reusing its buffer.
   /// \param[in] index The camera index to get calibration from.
-  void UndistortImage(cv::Mat&, int) const;
+  void UndistortImage(const cv::Mat& frame, cv::Mat& undistorted, int index) const;
 
   /// Adds all activity events from the tracker into an array.
   /// \param[in, out] last_frame The last frame before quitting.
   void AssembleEvents(int&) const;
 
-  /// Goes through each video and looks for a sync point.
+  /// Finds the sync point of both videos, and skips each of them to the
+  /// first frame after it.
   /// \returns True is both videos found a sync point point. False otherwise.
-  bool SyncVideos() const;
+  bool SyncVideos();
+
+  /// Matches the objects found in both cameras and adds their estimated
+  /// lengths, and optionally the depth of each object, to the currently
+  /// active event.
+  /// \param[in] frame_num The frame number.
+  /// \param[in] frames The undistorted frames of each camera.
+  /// \param[in] boxes The bounding boxes found in each camera.
+  void MeasureObjects(int frame_num, std::shared_ptr<cv::Mat> frames[2], const std::vector<cv::Rect> boxes[2]) const;
+
+  /// Samples the frames of the open event into its thumbnails, and hands
+  /// them over to the event once it ends.
+  /// \param[in] bWasActive Whether an event was open before this frame.
+  /// \param[in] frame_num The frame number.
+  /// \param[in] frames The undistorted frames of each camera.
+  /// \param[in] boxes The bounding boxes found in each camera.
+  void UpdateThumbnails(bool bWasActive, int frame_num, std::shared_ptr<cv::Mat> frames[2],
+                        const std::vector<cv::Rect> boxes[2]) const;
+
+  /// Finishes the thumbnails of an event which just ended and writes them
+  /// right away, named after its first frame until the events are numbered.
+  /// \param[in, out] event The event the thumbnails belong to.
+  void FinishThumbnails(ActivityEvent& event) const;
 
 public:
   bool Success;
+  Settings Config;
 
 private:
   std::unique_ptr<Video>        _videos[2];
   std::unique_ptr<Tracker>      _tracker;
   std::shared_ptr<JSON>         _detected_events;
   std::shared_ptr<Calibration>  _calib;
+  std::unique_ptr<StereoMeasure> _measure;
+  std::unique_ptr<Disparity>    _disparity;
+  std::shared_ptr<Metrics>      _metrics;
+  std::unique_ptr<SyncResult>   _sync;
+  std::unique_ptr<ThumbnailBuilder> _thumbnails;
 
 };
 
@@ -83,11 +205,24 @@ public:
   /// until it reads a non-empty frame.
   void Read();
 
+  /// Skips ahead to a frame without decoding the frames in between, where
+  /// the container allows it.
+  /// \param[in] frame The index of the next frame to read.
+  void Seek(int frame);
+
+  /// Gets the path the video was opened from.
+  /// \returns The path of the video file.
+  const std::string& GetPath() const;
+
   /// Returns a pointer to the current frame. If the frame is null, then the 
   /// video should be done.
   /// \returns Pointer to the current frame read from the video.
   std::shared_ptr<cv::Mat> Get() const;
 
+  /// Reads frames into buffers from a pool instead of allocating them.
+  /// \param[in] pool The pool shared by both videos, or null to allocate.
+  void SetFramePool(std::shared_ptr<FramePool> pool);
+
   /// Checks whether the video has ended or not.
   /// \returns True if the video frames are equal to the total frames, false
   /// otherwise.
@@ -102,9 +237,13 @@ public:
   int FPS;
   int FOURCC;
 
+  // Number of empty frames skipped while reading.
+  int Dropped;
+
 private:
   std::string _filepath;
   std::shared_ptr<cv::Mat> _frame;
   std::unique_ptr<cv::VideoCapture> _vid_cap;
+  std::shared_ptr<FramePool> _pool;
   mutable std::mutex _mutex;
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+/// \date October 16, 2026
+///
+/// A per-pixel running average motion detector for static camera rigs. The
+/// background update, the difference against the background, the threshold
+/// and the count of changed pixels all happen in a single pass over the
+/// frame, vectorized with OpenCV's universal intrinsics. The background is
+/// kept in 16 bit fixed point, which lets the whole pass run on 16 bit lanes.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+/// A background subtractor which compares each frame to an exponential
+/// moving average of the previous frames.
+class RunningAverage : public cv::BackgroundSubtractor
+{
+public:
+    /// Constructs a running average detector.
+    /// \param[in] threshold The minimum grey level difference of a moving pixel.
+    /// \param[in] shift The background learns 1/2^shift of each new frame.
+    RunningAverage(int threshold = 20, int shift = 5);
+
+    /// Updates the background and computes the foreground mask in one pass.
+    /// \param[in] frame The next frame, greyscale or BGR.
+    /// \param[out] mask The mask, 255 where the frame differs from the background.
+    /// \param[in] update Whether the frame is learned into the background.
+    /// \return The number of changed pixels.
+    int Apply(const cv::Mat& frame, cv::Mat& mask, bool update = true);
+
+    /// Computes the foreground mask, see Apply().
+    /// \param[in] image The next frame.
+    /// \param[out] fgmask The foreground mask.
+    /// \param[in] learningRate If 0, the background is left untouched. Any
+    ///                         other rate is fixed by the shift.
+    void apply(cv::InputArray image, cv::OutputArray fgmask, double learningRate = -1) override;
+
+    /// Gets the current background.
+    /// \param[out] backgroundImage The background as an 8 bit greyscale image.
+    void getBackgroundImage(cv::OutputArray backgroundImage) const override;
+
+private:
+    int _threshold;
+    int _shift;
+    cv::Mat _background;
+};
@@ -0,0 +1,106 @@
+/// \date October 16, 2026
+///
+/// Writes a video as numbered segments of a fixed number of frames instead of
+/// one file, so finished segments can be uploaded and deleted while the rest
+/// of the video is still being processed. A JSON manifest next to the segments
+/// lists every finished segment, and is marked complete once the last one is
+/// written. The manifest is replaced atomically, so anything it lists can be
+/// picked up at any time.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "JsonBuilder.h"
+
+#include <string>
+#include <vector>
+
+/// A finished segment of a video.
+struct VideoSegment
+{
+    int index = 0;
+    int frame_start = 0;
+    int frames = 0;
+    std::string file;
+};
+
+/// Writes frames into consecutive segment files, and keeps their manifest.
+class SegmentWriter
+{
+public:
+    /// Nested wrapper class for settings pertaining to segments.
+    struct Settings
+    {
+        // Frames per segment, and the container every segment is written in.
+        int SegmentFrames = 1800;
+        std::string Extension = ".mp4";
+    };
+
+public:
+    /// Constructor which sets up the segments of a video, without writing
+    /// anything until the first frame.
+    /// \param[in] dir The directory to write the segments and manifest to.
+    /// \param[in] name The name of the video, which every file starts with.
+    /// \param[in] fourcc The codec of the segments.
+    /// \param[in] fps The frame rate of the video.
+    /// \param[in] size The size of the frames.
+    /// \param[in] settings The settings for the segments.
+    SegmentWriter(std::string dir, std::string name, int fourcc, double fps, cv::Size size, Settings settings);
+
+    /// Finishes the last segment, if it was not already, but leaves the
+    /// manifest incomplete unless Close was called, e.g. when processing
+    /// failed part way through.
+    ~SegmentWriter();
+
+    /// Writes a frame, starting a new segment when the current one is full.
+    /// \param[in] frame The frame to write.
+    void Write(const cv::Mat& frame);
+
+    /// Finishes the last segment and marks the manifest complete. Only meant
+    /// once every frame was written.
+    void Close();
+
+    /// Gets the finished segments.
+    /// \return The segments, in order.
+    const std::vector<VideoSegment>& GetSegments() const;
+
+    /// Gets where the manifest is written.
+    /// \return The path of the manifest.
+    std::string GetManifestPath() const;
+
+    /// Formats the manifest of the finished segments.
+    /// \return The "Manifest" object, with the frame rate, the total frames,
+    ///         whether the video is complete, and every segment's file.
+    JSON ToJSON() const;
+
+    /// Gets the file name of a segment.
+    /// \param[in] name The name of the video.
+    /// \param[in] index The index of the segment.
+    /// \param[in] extension The container of the segment, e.g. ".mp4".
+    /// \return The file name, e.g. "name_003.mp4".
+    static std::string SegmentName(const std::string& name, int index, const std::string& extension);
+
+public:
+    /// Settings for the segments.
+    Settings Config;
+
+private:
+    /// Finishes the current segment, if any, and lists it in the manifest.
+    void FinishSegment();
+
+    /// Replaces the manifest with the current list of segments.
+    void WriteManifest() const;
+
+private:
+    std::string _dir, _name;
+    int _fourcc;
+    double _fps;
+    cv::Size _size;
+
+    cv::VideoWriter _writer;
+    VideoSegment _current;
+    std::vector<VideoSegment> _segments;
+    int _total_frames;
+    bool _closed;
+};
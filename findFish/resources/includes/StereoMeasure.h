@@ -0,0 +1,79 @@
+/// \date October 16, 2026
+///
+/// Automatic stereo measurement of tracked objects. Bounding boxes of the
+/// objects detected in each camera are mapped onto the rectified image planes,
+/// where a real object appears on the same rows in both cameras. Boxes are
+/// matched along those epipolar lines, and the extremes of each matched pair
+/// are triangulated into a real world length estimate.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+class Calibration;
+
+/// Matches objects between stereo cameras and estimates their lengths.
+class StereoMeasure
+{
+public:
+    /// Nested wrapper class for settings pertaining to stereo matching.
+    struct Settings
+    {
+        // Minimum fraction of shared rows for two boxes to be a match.
+        float MinRowOverlap = 0.5f;
+
+        // Lengths outside this range (mm) are discarded as bad matches.
+        float MinLength = 10.f;
+        float MaxLength = 3000.f;
+    };
+
+    /// A single matched object and its estimated length.
+    struct Measurement
+    {
+        int left_index;
+        int right_index;
+        float length;
+
+        // The matched boxes on the rectified image planes.
+        cv::Rect2f left_box;
+        cv::Rect2f right_box;
+    };
+
+public:
+    /// Constructs a measurer around a loaded stereo calibration.
+    /// \param[in] calib The stereo calibration with rectification results.
+    /// \param[in] settings The settings for matching.
+    StereoMeasure(std::shared_ptr<Calibration> calib, Settings settings);
+
+    /// Matches the objects of both cameras and estimates their lengths.
+    /// \param[in] left The bounding boxes in the undistorted left frame.
+    /// \param[in] right The bounding boxes in the undistorted right frame.
+    /// \return One measurement per matched pair of boxes.
+    std::vector<Measurement> MeasureObjects(const std::vector<cv::Rect>& left,
+                                            const std::vector<cv::Rect>& right) const;
+
+    /// Maps bounding boxes onto the rectified image plane of a camera.
+    /// \param[in] boxes The bounding boxes in undistorted frame coordinates.
+    /// \param[in] index The camera index the boxes belong to.
+    /// \return The bounding boxes in rectified coordinates.
+    std::vector<cv::Rect2f> RectifyBoxes(const std::vector<cv::Rect>& boxes, int index) const;
+
+    /// Greedily matches rectified boxes along epipolar lines, preferring boxes
+    /// which share the most rows and have the most similar heights.
+    /// \param[in] left The rectified left boxes.
+    /// \param[in] right The rectified right boxes.
+    /// \return Pairs of matched left and right indices.
+    std::vector<std::pair<int, int>> MatchBoxes(const std::vector<cv::Rect2f>& left,
+                                                const std::vector<cv::Rect2f>& right) const;
+
+public:
+    /// Settings for the measurer.
+    Settings Config;
+
+private:
+    std::shared_ptr<Calibration> _calib;
+};
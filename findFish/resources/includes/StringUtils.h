@@ -0,0 +1,58 @@
+/// \date October 16, 2026
+///
+/// Allocation-free string tokenizing. Strings are split into slices which
+/// point into the original string instead of copying it, and whitespace is
+/// trimmed by moving the ends of a slice, so parsing a QR payload or a path
+/// only allocates for the pieces that are kept.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// A read-only view of part of a string, only valid while that string is.
+class StringSlice
+{
+public:
+    StringSlice();
+    StringSlice(const std::string& str);
+    StringSlice(const char* data, size_t size);
+
+    /// Finds the first occurrence of a substring.
+    /// \param[in] needle The substring to find.
+    /// \return The position of the substring, or std::string::npos.
+    size_t Find(const char* needle) const;
+
+    /// Gets part of the slice, clamped to its end.
+    /// \param[in] pos The first character of the part.
+    /// \param[in] n The length of the part.
+    /// \return The part of the slice.
+    StringSlice Substr(size_t pos, size_t n = std::string::npos) const;
+
+    /// Removes whitespace from both ends.
+    /// \return The slice without leading and trailing whitespace.
+    StringSlice Trim() const;
+
+    /// Copies the slice into a string.
+    /// \return The characters of the slice.
+    std::string ToString() const;
+
+    const char* Data() const { return _data; }
+    size_t Size() const { return _size; }
+    bool Empty() const { return _size == 0; }
+
+    bool operator==(const StringSlice& other) const;
+    bool operator!=(const StringSlice& other) const { return !(*this == other); }
+
+private:
+    const char* _data;
+    size_t _size;
+};
+
+/// Splits a string on a delimiter and trims whitespace from every token. Empty
+/// tokens are kept, except for a trailing one.
+/// \param[in] str The string to split.
+/// \param[in] delimiter The character separating tokens.
+/// \return Slices of the tokens, pointing into str.
+std::vector<StringSlice> Tokenize(StringSlice str, char delimiter);
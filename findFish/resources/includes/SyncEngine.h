@@ -0,0 +1,161 @@
+/// \date October 16, 2026
+///
+/// Finds the frame offset between the two videos of a stereo pair. Instead of
+/// stopping at the first frame where a QR code decodes, which depends on how
+/// blurred the card is, the whole stretch of frames where the code is visible
+/// is found in both videos and their midpoints are aligned. The offset can
+/// then be refined to a fraction of a frame by cross-correlating the global
+/// brightness of both videos around the sync, where the card coming in and
+/// out of view gives a strong signal.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "Metrics.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class JSON;
+
+/// The alignment of a stereo pair.
+struct SyncResult
+{
+    bool found = false;
+
+    // First and last frames of each video where the QR code is visible.
+    int qr_first[2] = { -1, -1 };
+    int qr_last[2] = { -1, -1 };
+
+    // A frame of the left video shows the same moment as the frame offset
+    // frames later in the right video, give or take the sub-frame refinement.
+    int offset = 0;
+    double refinement = 0.0;
+    double confidence = 0.0;
+
+    // First frame of each video to process, just after the QR code.
+    int start[2] = { 0, 0 };
+
+    // The URL decoded from the QR code.
+    std::string url;
+
+    /// Formats the alignment as the QR code event of the events JSON.
+    /// \return The JSON object named "Event_QRCode".
+    JSON ToJSON() const;
+};
+
+/// Searches both videos of a pair for their sync point.
+class SyncEngine
+{
+public:
+    /// Nested wrapper class for settings pertaining to syncing.
+    struct Settings
+    {
+        // Only this many frames at the start of each video are searched.
+        int MaxSearchFrames = 900;
+
+        // The QR code is considered gone after this many frames without it,
+        // so blurred frames in between do not end it early.
+        int MaxQRGap = 15;
+
+        // Brightness refinement, over the QR frames and RefineFrames more,
+        // trying shifts of up to MaxRefineShift frames. It is only applied
+        // when the correlation is at least MinConfidence.
+        bool bRefineBrightness = true;
+        int RefineFrames = 90;
+        int MaxRefineShift = 3;
+        double MinConfidence = 0.5;
+    };
+
+public:
+    /// Constructor which takes in some settings object.
+    /// \param[in] settings The settings for syncing.
+    SyncEngine(Settings settings);
+
+    /// Searches the start of both videos for their sync point.
+    /// \param[in] left The path of the left video.
+    /// \param[in] right The path of the right video.
+    /// \return The alignment, which is not found if either video has no QR code.
+    SyncResult Sync(const std::string& left, const std::string& right) const;
+
+    /// Finds the shift between two brightness series with the highest
+    /// normalized cross-correlation around a first estimate.
+    /// \param[in] left The brightness of every frame of the left video.
+    /// \param[in] right The brightness of every frame of the right video.
+    /// \param[in] offset The estimated offset of the right video.
+    /// \param[in] max_shift The largest correction to try, in frames.
+    /// \param[out] confidence The correlation at the best shift.
+    /// \return The correction to the offset, in fractions of a frame.
+    static double RefineOffset(const std::vector<double>& left, const std::vector<double>& right,
+                               int offset, int max_shift, double& confidence);
+
+    /// Records the latency of finding and decoding the QR code in every
+    /// frame, as the "qr" stage, into some metrics.
+    /// \param[in] metrics The metrics to record into, or null to stop.
+    void SetMetrics(std::shared_ptr<Metrics> metrics);
+
+public:
+    /// Settings for syncing.
+    Settings Config;
+
+private:
+    /// What was found while searching a single video.
+    struct Scan
+    {
+        int qr_first = -1;
+        int qr_last = -1;
+        std::string url;
+        std::vector<double> brightness;
+    };
+
+    /// Searches the start of a video for its QR code.
+    /// \param[in] file The path of the video.
+    /// \return The QR frames, and the brightness of every frame read.
+    Scan ScanVideo(const std::string& file) const;
+
+    std::shared_ptr<Metrics> _metrics;
+};
+
+/// Sync results of previously processed pairs, stored in a YAML file and keyed
+/// by the fingerprints of both videos. Several processes may share the file,
+/// so it is only read or rewritten while holding a lock on "<file>.lock".
+class SyncCache
+{
+public:
+    /// Reads the cache, keeping only results found with the same settings.
+    /// \param[in] file The path of the cache file.
+    /// \param[in] settings The settings results are found with, every one of
+    ///                     which has to match.
+    SyncCache(std::string file, SyncEngine::Settings settings);
+
+    /// Looks up the result for a pair of videos.
+    /// \param[in] left The fingerprint of the left video.
+    /// \param[in] right The fingerprint of the right video.
+    /// \param[out] result The cached result, if any.
+    /// \return True if the pair was cached.
+    bool Find(uint64_t left, uint64_t right, SyncResult& result) const;
+
+    /// Adds or replaces the result for a pair of videos.
+    /// \param[in] left The fingerprint of the left video.
+    /// \param[in] right The fingerprint of the right video.
+    /// \param[in] result The result to cache.
+    void Store(uint64_t left, uint64_t right, const SyncResult& result);
+
+    /// Writes every cached result back to the cache file, along with those
+    /// other processes wrote since it was read.
+    void Write() const;
+
+private:
+    /// Reads the results in the cache file, if it was written with the same
+    /// settings. The file has to be locked already.
+    /// \param[in, out] results The results to add to.
+    void Read(std::map<std::string, SyncResult>& results) const;
+
+    std::string _file;
+    SyncEngine::Settings _settings;
+    std::map<std::string, SyncResult> _results;
+};
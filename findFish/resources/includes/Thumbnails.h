@@ -0,0 +1,110 @@
+/// \date October 16, 2026
+///
+/// Builds small previews of activity events out of the frames which are
+/// decoded for processing anyway, so reviewers can find fish without scrubbing
+/// through the whole video, and without decoding it a second time. While an
+/// event is open, frames are sampled at a stride which doubles whenever the
+/// samples fill up, so any event length fits in a fixed number of thumbnails,
+/// and a close up of the largest object is kept. The images are written as
+/// soon as their event ends, and only renamed once the events are numbered.
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+#include "EventDetector.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Samples the frames of one activity event at a time into thumbnails.
+class ThumbnailBuilder
+{
+public:
+    /// Nested wrapper class for settings pertaining to thumbnails.
+    struct Settings
+    {
+        // Frame pairs in the keyframe strip, and the height they are shrunk to.
+        int Keyframes = 6;
+        int Height = 96;
+
+        // The close up of the largest object is its box grown by Padding on
+        // every side, shrunk to fit within KeyframeSize.
+        float Padding = 0.25f;
+        int KeyframeSize = 256;
+
+        // Image format, ".jpg" or ".webp", and its quality from 0 to 100.
+        std::string Format = ".jpg";
+        int Quality = 80;
+    };
+
+public:
+    /// Constructor which takes in some settings object.
+    /// \param[in] settings The settings for the thumbnails.
+    ThumbnailBuilder(Settings settings);
+
+    /// Starts sampling a new event, dropping anything left from the last one.
+    /// \param[in] frame The first frame of the event.
+    void Start(int frame);
+
+    /// Samples a frame pair of the open event.
+    /// \param[in] frame The frame number.
+    /// \param[in] frames The undistorted frames of each camera.
+    /// \param[in] boxes The boxes of the objects found in each camera.
+    void Add(int frame, const cv::Mat frames[2], const std::vector<cv::Rect> boxes[2]);
+
+    /// Encodes the thumbnails of the open event and closes it.
+    /// \return The encoded keyframe strip and close up.
+    EventThumbnails Finish();
+
+    /// Checks whether an event is being sampled.
+    /// \return True between Start and Finish.
+    bool IsOpen() const;
+
+    /// Writes encoded thumbnails as "<base>_strip<format>" and
+    /// "<base>_keyframe<format>", and frees the encoded images. The files are
+    /// removed by RemoveUnused unless they are renamed first.
+    /// \param[in, out] thumbnails The thumbnails, which get their file names.
+    /// \param[in] base The path and name to write to, without extension.
+    void Write(EventThumbnails& thumbnails, const std::string& base);
+
+    /// Moves written thumbnails to "<base>_strip<format>" and
+    /// "<base>_keyframe<format>", e.g. once their event has its final ID.
+    /// \param[in, out] thumbnails The thumbnails, which get their new names.
+    /// \param[in] base The path and name to move to, without extension.
+    void Rename(EventThumbnails& thumbnails, const std::string& base);
+
+    /// Removes every written file which was not renamed since, e.g. those of
+    /// events which were dropped or merged into another.
+    void RemoveUnused();
+
+public:
+    /// Settings for the thumbnails.
+    Settings Config;
+
+private:
+    /// Encodes an image in the configured format.
+    /// \param[in] image The image to encode.
+    /// \return The encoded bytes.
+    std::vector<uchar> Encode(const cv::Mat& image) const;
+
+    /// Moves a written file, and keeps it from being removed.
+    /// \param[in, out] file The file to move, which gets its new path.
+    /// \param[in] to The path to move it to.
+    void Move(std::string& file, const std::string& to);
+
+private:
+    bool _open;
+    int _start, _stride;
+    std::vector<std::pair<int, cv::Mat>> _samples;
+
+    // The largest object seen so far.
+    double _best_area;
+    int _best_frame, _best_camera;
+    cv::Rect _best_box;
+    cv::Mat _best;
+
+    // Files written but not renamed yet.
+    std::vector<std::string> _written;
+};
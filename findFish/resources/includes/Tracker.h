@@ -10,16 +10,72 @@
 
 #include <opencv2/opencv.hpp>
 #include <opencv2/objdetect.hpp>
+
+#include "DnnDetector.h"
+#include "EventDetector.h"
+#include "Metrics.h"
+#include "ObjectTracker.h"
+
 #include <map>
+#include <memory>
+#include <string>
 
 /// Uses background subtraction and thresholding to detect motion in an image.
 class Tracker
 {
 public:
+    /// The available background subtraction methods, roughly from the most to
+    /// the least expensive per pixel. GSOC, LSBP and CNT come from the contrib
+    /// bgsegm module.
+    enum class Backend { KNN, MOG2, GSOC, LSBP, CNT, FRAME_DIFF, RUNNING_AVG };
+
     /// Nested wrapper class for settings pertaining to motion detection
     /// and edge detection.
     struct Settings
     {
+        // Background Subtraction Settings
+        Backend Subtractor = Backend::KNN;
+        int FrameDiffThreshold = 25;
+
+        // Running Average Settings. Frames with fewer changed pixels than
+        // MinChangedPixels skip the mask clean up and contour extraction.
+        int RunningAvgThreshold = 20;
+        int RunningAvgShift = 5;
+        int MinChangedPixels = 50;
+
+        // Activity Gate Settings. Contours are only extracted when some tile
+        // of the mask has more than MinTileArea foreground pixels.
+        bool bUseActivityGate = true;
+        int GateTileSize = 64;
+        int MinTileArea = 32;
+
+        // Cascade Settings. Every cascade in CascadeDir is named after the
+        // species it detects, and only runs inside the boxes of moving objects,
+        // grown by CascadePadding on every side.
+        std::string CascadeDir = "cascades/";
+        float CascadePadding = 0.25f;
+        int CascadeMinSize = 24;
+
+        // Object Tracking Settings
+        bool bTrackObjects = true;
+        ObjectTracker::Settings ObjectTracking;
+
+        // Learned Detector Settings. When enabled, the boxes of moving objects
+        // are batched through the network and its detections are added to
+        // the activity events.
+        bool bUseDnn = false;
+        DnnDetector::Settings Dnn;
+
+        // Event Settings. An event starts after EnterFrames checked frames in
+        // a row with objects, and ends after ExitFrames without, at the first
+        // frame of each run. Once tracking is done, events less than MergeGap
+        // frames apart are merged and events shorter than MinEventFrames are
+        // dropped.
+        int EnterFrames = 1;
+        int ExitFrames = 1;
+        int MergeGap = 0;
+        int MinEventFrames = 1;
+
         // Contour Settings
         bool bDrawContours = false;
         
@@ -28,40 +84,167 @@ public:
         int MinThreshold = 250;
     };
 
+    /// A frame pair which was not tracked while idle.
+    struct SkippedFrame
+    {
+        int frame_num;
+        std::shared_ptr<cv::Mat> frames[2];
+    };
+
 public:
     /// Constructor which takes in some settings object.
     /// \param[in] settings The settings for the tracker.
     Tracker(Settings settings);
 
-    /// Empties the activity event array.
-    ~Tracker();
-
-    /// Creates the background subtracted masked image.
+    /// Creates the background subtracted masked image. Every camera keeps its
+    /// own background model.
     /// \param[in, out] img The image/frame to be masked.
-    void CreateMask(cv::Mat& img);
+    /// \param[in] camera The index of the camera the frame came from.
+    /// \param[in] learning_rate The background learning rate, -1 for the
+    ///                          backend's default and 0 to leave it untouched.
+    void CreateMask(cv::Mat& img, int camera = 0, double learning_rate = -1);
 
     /// Finds the contours of all detected objects in a frame.
     /// \param[in, out] img The image/frame for which to detect contours.
-    void GetObjectContours(cv::Mat&);
+    /// \param[in] camera The index of the camera the frame came from.
+    void GetObjectContours(cv::Mat&, int camera = 0);
+
+    /// Checks a frame for objects without learning it into the background,
+    /// touching the activity events, or replacing what was found in the last
+    /// tracked frame.
+    /// \param[in, out] img The image/frame to check.
+    /// \param[in] camera The index of the camera the frame came from.
+    /// \return True if any objects were found.
+    bool ProbeFrame(cv::Mat& img, int camera = 0);
+
+    /// Keeps a frame pair which was not tracked while idle, in case an event
+    /// turns out to have started there. Frames skipped before a run of frames
+    /// with objects are kept until the run opens an event, which is then
+    /// backdated to the first of them with objects, or until the run ends.
+    /// \param[in] skipped The frame pair, which is kept as it is.
+    void SkipFrame(const SkippedFrame& skipped);
+
+    /// Gets how many skipped frame pairs are kept.
+    /// \return The number of frame pairs.
+    size_t GetSkippedCount() const;
+
+    /// Moves the start of the current activity event back to an earlier frame.
+    /// \param[in] frame The frame where the activity really started.
+    void BackdateActivity(int frame);
+
+    /// Ends the current activity event, if any, when the video ends, and
+    /// merges and filters all of the events.
+    /// \param[in, out] frame The last frame of the event.
+    void EndActivity(int& frame);
 
-    /// Checks to see if there are objects found in  the frame.
+    /// Checks whether an activity event is currently open.
+    /// \return True while there is activity.
+    bool IsActive() const;
+
+    /// Checks whether any tile of a mask has enough foreground to be worth
+    /// extracting contours from.
+    /// \param[in] mask The thresholded mask.
+    /// \return True if a tile has more than MinTileArea foreground pixels.
+    bool HasActivity(const cv::Mat& mask) const;
+
+    /// Checks to see if there are objects found in the last frame of any
+    /// camera. Should be called once per frame, after every camera's mask.
     /// \param[in, out] currentFrame The current frame number.
     void CheckForActivity(int&);
 
-    /// Gets all cascade classifiers.
+    /// Loads every cascade classifier (*.xml or *.yaml) in the cascade
+    /// directory, keyed by the file name without its extension.
     void GetCascades();
 
+    /// Runs the cascade classifiers on the moving objects of the last frame.
+    /// \param[in] frame The image/frame the objects were found in.
+    /// \param[in] camera The index of the camera the frame came from.
+    void DetectSpecies(const cv::Mat& frame, int camera = 0);
+
+    /// Gets the species detected among the objects of the last frame.
+    /// \param[in] camera The index of the camera.
+    /// \return One species name per detection.
+    const std::vector<std::string>& GetSpeciesCandidates(int camera = 0) const;
+
+    /// Gets the bounding rectangles of all objects found in the last frame.
+    /// \param[in] camera The index of the camera.
+    /// \return One rectangle per detected contour.
+    std::vector<cv::Rect> GetBoundingBoxes(int camera = 0) const;
+
+    /// Records the latencies of the tracker's stages into some metrics.
+    /// \param[in] metrics The metrics to record into, or null to stop.
+    void SetMetrics(std::shared_ptr<Metrics> metrics);
+
+    /// Gets the learned detector stage, for its timings.
+    /// \return The detector, or null when it is disabled.
+    const DnnDetector* GetDetector() const;
+
+    /// Creates a background subtractor.
+    /// \param[in] settings The settings selecting and tuning the backend.
+    /// \return The new background subtractor.
+    static cv::Ptr<cv::BackgroundSubtractor> CreateSubtractor(const Settings& settings);
+
+    /// Looks up a backend by name, e.g. from a deployment's configuration.
+    /// \param[in] name The name of the backend, e.g. "CNT".
+    /// \return The backend with that name.
+    static Backend GetBackend(const std::string& name);
+
+    /// Merges events less than MergeGap frames apart, drops events shorter
+    /// than MinEventFrames, and numbers the remaining events from 1.
+    /// \param[in, out] events The events, in order.
+    /// \param[in] settings The settings with the event limits.
+    static void FilterEvents(std::vector<ActivityEvent>& events, const Settings& settings);
+
+    /// Gets the printable name of a backend.
+    /// \param[in] backend The backend.
+    /// \return The name of the backend, e.g. "KNN".
+    static std::string GetBackendName(Backend backend);
+
 public:
     /// Settings for the Tracker.
     Settings Config;
 
-    /// Container for all activity events detected.
-    std::vector<class ActivityEvent*> ActivityRange;
+    /// Container for all activity events detected, in order. Only the last
+    /// one can still be active, and only the tracker changes them while
+    /// frames are checked.
+    std::vector<ActivityEvent> ActivityRange;
 
 private:
-    cv::Mat _mask;
-    cv::Ptr<cv::BackgroundSubtractor> bkgd_sub_ptr;
-    std::map<int, cv::Ptr<cv::CascadeClassifier>> cascades;
-    std::vector<std::vector<cv::Point>> contours;
+    /// Hands the tracks of every camera over to an event.
+    /// \param[in, out] event The event the tracks belong to.
+    void AttachTracks(ActivityEvent& event);
+
+    /// Runs the learned detector on anything still queued, and hands its
+    /// detections over to an event.
+    /// \param[in, out] event The event the detections belong to.
+    void AttachDetections(ActivityEvent& event);
+
+    /// Hands everything gathered during the open event over to it, and ends it.
+    /// \param[in] frame The last frame of the event.
+    void CloseActivity(int frame);
+
+    /// Backdates the event which was just opened to the first frame with
+    /// objects among those skipped before its run of frames with objects.
+    void BackfillActivity();
+
+private:
+    cv::Mat _mask[2];
+    cv::Ptr<cv::BackgroundSubtractor> bkgd_sub_ptr[2];
+    std::map<std::string, cv::Ptr<cv::CascadeClassifier>> cascades;
+    std::vector<std::string> _species[2];
+    std::vector<std::vector<cv::Point>> contours[2];
+    ObjectTracker _objects[2];
+    cv::Mat _frame[2];
+    std::unique_ptr<DnnDetector> _dnn;
+    std::shared_ptr<Metrics> _metrics;
     bool bIsActive;
+
+    // Lengths and first frames of the current runs of checked frames with
+    // and without objects.
+    int _found_frames, _found_since;
+    int _missing_frames, _missing_since;
+
+    // Frames skipped since the last tracked frame, and those skipped before
+    // the current run of frames with objects.
+    std::vector<SkippedFrame> _skipped, _skipped_before;
 };
\ No newline at end of file
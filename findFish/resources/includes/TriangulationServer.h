@@ -0,0 +1,88 @@
+/// \date October 16, 2026
+///
+/// A long running triangulation service for the measurement UI. Rather than
+/// spawning a process, round tripping YAML files, and reloading the stereo
+/// calibration for every measurement, the server keeps the calibration loaded
+/// and answers line based requests either on stdin/stdout or on a Unix domain
+/// socket.
+///
+/// Each request is a single line of numbers in groups of four, one group per
+/// measured point: "x_left y_left x_right y_right". Numbers may be separated
+/// by spaces or commas. Each response is a single line of JSON, either
+/// {"Points":[[x,y,z],...]} or {"Error":"..."}, along with how long the
+/// request took in "latency_us".
+
+#pragma once
+
+#include <atomic>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class Calibration;
+
+/// Answers triangulation requests using an already loaded stereo calibration.
+class TriangulationServer
+{
+public:
+    /// Constructs a server around a loaded stereo calibration.
+    /// \param[in] calib The calibration used to triangulate points.
+    TriangulationServer(std::shared_ptr<Calibration> calib);
+
+    /// Closes the listening socket, if any, and every connection.
+    ~TriangulationServer();
+
+    /// Answers requests read line by line until the input stream ends.
+    /// \param[in, out] in The stream to read requests from.
+    /// \param[in, out] out The stream to write responses to.
+    void Serve(std::istream& in, std::ostream& out) const;
+
+    /// Listens on a Unix domain socket, answering every connection on its own
+    /// thread until Stop() is called.
+    /// \param[in] socket_path The filesystem path of the socket.
+    void Listen(const std::string& socket_path);
+
+    /// Stops accepting new connections, and closes the open ones once their
+    /// threads are done.
+    void Stop();
+
+    /// Triangulates the points in a single request.
+    /// \param[in] request One request line.
+    /// \return The JSON formatted response line, without a trailing newline.
+    std::string HandleRequest(const std::string& request) const;
+
+private:
+    /// A connected client, and the thread answering it.
+    struct Connection
+    {
+        int fd;
+        std::atomic<bool> bDone;
+        std::thread thread;
+    };
+
+    /// Triangulates the points in a single request.
+    /// \param[in] request One request line.
+    /// \return The members of the JSON response, without the braces.
+    std::string Triangulate(const std::string& request) const;
+
+    /// Answers requests on a single connected socket until the client hangs
+    /// up, or the connection is shut down.
+    /// \param[in, out] connection The connection, which is marked done.
+    void ServeConnection(Connection* connection) const;
+
+    /// Waits for the threads of finished connections and closes them.
+    /// \param[in] bAll Whether to wait for every connection, e.g. when stopping.
+    void CloseConnections(bool bAll);
+
+private:
+    std::shared_ptr<Calibration> _calib;
+    std::atomic<bool> _running;
+    int _socket_fd;
+    std::string _socket_path;
+
+    std::mutex _connections_mutex;
+    std::list<std::unique_ptr<Connection>> _connections;
+};
@@ -39,6 +39,11 @@ func main() {
 	os.Setenv("procVidFolder", "80573476756")
 	os.Setenv("vidInfoFolder", "82388040956")
 
+	// Full resolution videos, which are only archived separately when
+	// FishFinder writes proxies to procVidFolder. Proxies need this set, or
+	// the archives stay on the server.
+	os.Setenv("archiveVidFolder", "")
+
 	// Box calibration folders
 	os.Setenv("calibFolder", "81405395430")
 	os.Setenv("calibImgFolder", "81405876091")
@@ -49,6 +54,7 @@ func main() {
 	goFish := &GoFish{NewServer(), NewBox("private_config/box_jwt.json"), ""}
 
 	go goFish.ProcessAndUploadVideos("./static/videos/")
+	go goFish.UploadSegments("./static/segments/")
 	go goFish.CalibrateCameras()
 
 	goFish.StartServer()
@@ -169,6 +175,12 @@ func (goFish *GoFish) ProcessAndUploadVideos(args ...string) {
 										goFish.box.UploadFile("./static/proc_videos/"+file.Name(), file.Name(), os.Getenv("procVidFolder"))
 										os.Remove("./static/proc_videos/" + file.Name())
 										goFish.box.UploadFile("./static/video-info/DE_"+strings.TrimSuffix(file.Name(), ".mp4")+".json", "DE_"+strings.TrimSuffix(file.Name(), ".mp4")+".json", os.Getenv("vidInfoFolder"))
+										if os.Getenv("archiveVidFolder") != "" {
+											if _, err := os.Stat("./static/archive_videos/" + file.Name()); err == nil {
+												goFish.box.UploadFile("./static/archive_videos/"+file.Name(), file.Name(), os.Getenv("archiveVidFolder"))
+												os.Remove("./static/archive_videos/" + file.Name())
+											}
+										}
 									}
 								}
 							}
@@ -180,6 +192,60 @@ func (goFish *GoFish) ProcessAndUploadVideos(args ...string) {
 	}
 }
 
+// UploadSegments : Uploads the finished segments of full resolution videos
+// while they are still being processed, then their manifests once complete.
+func (goFish *GoFish) UploadSegments(segmentDir string) {
+	// Manifest : The segments FishFinder has finished writing for a video.
+	type Manifest struct {
+		Manifest struct {
+			Complete bool `json:"complete"`
+			Segments []map[string]struct {
+				File string `json:"file"`
+			} `json:"segments"`
+		} `json:"Manifest"`
+	}
+
+	for {
+		time.Sleep(1 * time.Second)
+		if os.Getenv("archiveVidFolder") == "" {
+			continue
+		}
+
+		videos, err := ioutil.ReadDir(segmentDir)
+		if err != nil {
+			continue
+		}
+		for _, video := range videos {
+			if !video.IsDir() {
+				continue
+			}
+			dir := segmentDir + video.Name() + "/"
+			file, err := ioutil.ReadFile(dir + video.Name() + ".json")
+			if err != nil {
+				continue
+			}
+
+			var manifest Manifest
+			if json.Unmarshal(file, &manifest) != nil {
+				continue
+			}
+			for _, segment := range manifest.Manifest.Segments {
+				for _, v := range segment {
+					if _, err := os.Stat(dir + v.File); err == nil {
+						goFish.box.UploadFile(dir+v.File, v.File, os.Getenv("archiveVidFolder"))
+						os.Remove(dir + v.File)
+					}
+				}
+			}
+
+			if manifest.Manifest.Complete {
+				goFish.box.UploadFile(dir+video.Name()+".json", video.Name()+".json", os.Getenv("archiveVidFolder"))
+				os.RemoveAll(dir)
+			}
+		}
+	}
+}
+
 // CalibrateCameras : Calibrates files from specified directories.
 func (goFish *GoFish) CalibrateCameras() {
 	for {
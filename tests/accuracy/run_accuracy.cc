@@ -0,0 +1,297 @@
+/// \date October 16, 2026
+///
+/// Accuracy-vs-speed regression suite for activity detection. Every tracker
+/// configuration runs over the same fixtures, and the activity events it emits
+/// are matched against ground truth: an event matches a true event when both
+/// its start and end are within the frame tolerance. Precision, recall and the
+/// frames per second of each configuration are printed side by side, and the
+/// run fails if any configuration's F1 score falls too far below the KNN
+/// reference, so faster options can be adopted knowing their cost.
+///
+/// Fixtures are synthetic stereo footage by default. Recorded footage can be
+/// added as YAML files with "left" and "right" video paths and an "events"
+/// list of inclusive [start, end] frame pairs.
+///
+/// Usage: run_accuracy [tolerance] [fixture.yaml...]
+
+#include "Synthetic.h"
+#include "Tracker.h"
+#include "EventDetector.h"
+
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define DEFAULT_TOLERANCE 10
+#define MAX_F1_DROP 0.1
+
+typedef std::vector<std::pair<int, int>> Ranges;
+
+/// A source of stereo frames with known activity.
+struct Fixture
+{
+    std::string name;
+    Ranges truth;
+
+    // Reads the index-th frame pair, which is frame first_frame + index of
+    // the ground truth, and returns false at the end of the fixture.
+    int first_frame;
+    std::function<bool(int, cv::Mat*)> read;
+};
+
+/// A tracker configuration under test.
+struct Configuration
+{
+    std::string name;
+    Tracker::Settings settings;
+    int idle_stride;
+};
+
+/// The score of a configuration on a fixture.
+struct Score
+{
+    size_t matched = 0;
+    size_t predicted = 0;
+    size_t truth = 0;
+    double seconds = 0.0;
+    int frames = 0;
+};
+
+std::vector<Fixture> GetFixtures(int, char**);
+std::vector<Configuration> GetConfigurations();
+Ranges RunConfiguration(const Configuration&, const Fixture&, double&, int&);
+size_t MatchEvents(const Ranges&, const Ranges&, int);
+double F1(const Score&);
+
+int main(int argc, char** argv)
+{
+    int tolerance = argc > 1 ? std::atoi(argv[1]) : DEFAULT_TOLERANCE;
+
+    auto fixtures = GetFixtures(argc, argv);
+    auto configurations = GetConfigurations();
+
+    std::printf("%-24s %10s %10s %8s %8s %8s\n", "configuration", "precision", "recall", "f1", "fps", "events");
+    double reference = -1.0;
+    bool bPassed = true;
+    for (auto& config : configurations)
+    {
+        Score score;
+        for (auto& fixture : fixtures)
+            try
+            {
+                double seconds = 0.0;
+                int frames = 0;
+                auto events = RunConfiguration(config, fixture, seconds, frames);
+
+                score.matched += MatchEvents(events, fixture.truth, tolerance);
+                score.predicted += events.size();
+                score.truth += fixture.truth.size();
+                score.seconds += seconds;
+                score.frames += frames;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << " !> " << fixture.name << ": " << e.what() << '\n';
+                bPassed = false;
+            }
+
+        double f1 = F1(score);
+        if (reference < 0.0) reference = f1;
+        bool bRegressed = f1 < reference - MAX_F1_DROP;
+        bPassed = bPassed && !bRegressed;
+
+        std::printf("%-24s %10.3f %10.3f %8.3f %8.1f %8zu%s\n", config.name.c_str(),
+                    score.predicted > 0 ? (double)score.matched / score.predicted : 0.0,
+                    score.truth > 0 ? (double)score.matched / score.truth : 0.0, f1,
+                    score.seconds > 0.0 ? score.frames / score.seconds : 0.0, score.predicted,
+                    bRegressed ? "  !> regressed" : "");
+    }
+
+    return bPassed ? 0 : 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<Fixture> GetFixtures(int argc, char** argv)
+{
+    std::vector<Fixture> fixtures;
+
+    // Synthetic footage at two sizes, undistorted the way the Processor does.
+    // Tracking starts right after the QR code, like it does after syncing.
+    for (auto size : { cv::Size(640, 480), cv::Size(1280, 720) })
+    {
+        SyntheticStereo::Settings s_conf;
+        s_conf.FrameSize = size;
+        s_conf.Frames = 400;
+        auto synthetic = std::make_shared<SyntheticStereo>(s_conf);
+
+        Fixture fixture;
+        fixture.name = "synthetic-" + std::to_string(size.width) + "x" + std::to_string(size.height);
+        fixture.first_frame = s_conf.QRFrames;
+        fixture.truth = synthetic->Activity();
+        fixture.read = [synthetic](int index, cv::Mat* frames) {
+            int frame = synthetic->Config.QRFrames + index;
+            if (frame >= synthetic->Config.Frames) return false;
+            for (int i = 0; i < 2; i++)
+                cv::undistort(synthetic->Frame(i, frame), frames[i], synthetic->CameraMatrix(), synthetic->DistCoeffs());
+            return true;
+        };
+        fixtures.push_back(fixture);
+    }
+
+    // Recorded footage, read in order.
+    for (int i = 2; i < argc; i++)
+    {
+        cv::FileStorage fs(argv[i], cv::FileStorage::READ);
+        if (!fs.isOpened())
+            throw std::runtime_error("Fixture \"" + std::string(argv[i]) + "\" could not be opened!");
+
+        std::string files[2];
+        std::vector<int> events;
+        fs["left"] >> files[0];
+        fs["right"] >> files[1];
+        fs["events"] >> events;
+
+        auto caps = std::make_shared<std::vector<cv::VideoCapture>>();
+        for (auto& file : files)
+            caps->push_back(cv::VideoCapture(file));
+
+        Fixture fixture;
+        fixture.name = argv[i];
+        fixture.first_frame = 0;
+        for (size_t e = 0; e + 1 < events.size(); e += 2)
+            fixture.truth.push_back(std::make_pair(events[e], events[e + 1]));
+        fixture.read = [caps, files](int index, cv::Mat* frames) {
+            // Every configuration reads the videos from the start.
+            if (index == 0)
+                for (int c = 0; c < 2; c++)
+                    (*caps)[c].open(files[c]);
+            return (*caps)[0].read(frames[0]) && (*caps)[1].read(frames[1]);
+        };
+        fixtures.push_back(fixture);
+    }
+
+    return fixtures;
+}
+
+std::vector<Configuration> GetConfigurations()
+{
+    // Same settings as the Processor uses, with KNN first as the reference.
+    Tracker::Settings base;
+    base.bDrawContours = false;
+    base.MinThreshold = 200;
+    base.CascadeDir = "";
+    base.EnterFrames = 2;
+    base.ExitFrames = 3;
+    base.MergeGap = 15;
+    base.MinEventFrames = 5;
+
+    std::vector<Configuration> configurations;
+    for (auto backend : { Tracker::Backend::KNN, Tracker::Backend::MOG2, Tracker::Backend::GSOC,
+                          Tracker::Backend::LSBP, Tracker::Backend::CNT, Tracker::Backend::FRAME_DIFF,
+                          Tracker::Backend::RUNNING_AVG })
+    {
+        Tracker::Settings settings = base;
+        settings.Subtractor = backend;
+        configurations.push_back(Configuration{ Tracker::GetBackendName(backend), settings, 1 });
+    }
+
+    // The speed options layered on the cheapest and the reference backends.
+    for (auto backend : { Tracker::Backend::KNN, Tracker::Backend::RUNNING_AVG })
+    {
+        Tracker::Settings settings = base;
+        settings.Subtractor = backend;
+        std::string name = Tracker::GetBackendName(backend);
+        configurations.push_back(Configuration{ name + " stride 4", settings, 4 });
+
+        settings.bUseActivityGate = false;
+        configurations.push_back(Configuration{ name + " no gate", settings, 1 });
+    }
+
+    // Every change of the mask as its own event, as before event filtering.
+    Tracker::Settings raw = base;
+    raw.EnterFrames = raw.ExitFrames = raw.MinEventFrames = 1;
+    raw.MergeGap = 0;
+    configurations.push_back(Configuration{ "KNN raw events", raw, 1 });
+
+    return configurations;
+}
+
+Ranges RunConfiguration(const Configuration& config, const Fixture& fixture, double& seconds, int& frames)
+{
+    Tracker tracker(config.settings);
+
+    // Frames skipped while idle are handed to the tracker, the same way
+    // Processor does, so events are backdated to them.
+    int64 ticks = 0;
+    int frame_num = fixture.first_frame;
+    cv::Mat images[2];
+    for (frames = 0; fixture.read(frames, images); frames++, frame_num++)
+    {
+        int64 start = cv::getTickCount();
+        bool bTrack = tracker.IsActive() || config.idle_stride <= 1 || frame_num % config.idle_stride == 0;
+        if (bTrack)
+        {
+            for (int i = 0; i < 2; i++)
+                tracker.CreateMask(images[i], i);
+            tracker.CheckForActivity(frame_num);
+        }
+        else tracker.SkipFrame(Tracker::SkippedFrame{ frame_num, { std::make_shared<cv::Mat>(images[0].clone()),
+                                                                   std::make_shared<cv::Mat>(images[1].clone()) } });
+        ticks += cv::getTickCount() - start;
+    }
+
+    int last_frame = frame_num - 1;
+    tracker.EndActivity(last_frame);
+    seconds = (double)ticks / cv::getTickFrequency();
+
+    Ranges events;
+    for (auto& event : tracker.ActivityRange)
+        events.push_back(event.GetRange());
+    return events;
+}
+
+size_t MatchEvents(const Ranges& events, const Ranges& truth, int tolerance)
+{
+    // Every true event can match at most one event, and the other way around,
+    // so greedily pair the closest ones first.
+    std::vector<std::pair<int, std::pair<size_t, size_t>>> candidates;
+    for (size_t e = 0; e < events.size(); e++)
+        for (size_t t = 0; t < truth.size(); t++)
+        {
+            int start = std::abs(events[e].first - truth[t].first);
+            int end = std::abs(events[e].second - truth[t].second);
+            if (start <= tolerance && end <= tolerance)
+                candidates.push_back(std::make_pair(start + end, std::make_pair(e, t)));
+        }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<bool> used_events(events.size(), false), used_truth(truth.size(), false);
+    size_t matched = 0;
+    for (auto& candidate : candidates)
+    {
+        size_t e = candidate.second.first, t = candidate.second.second;
+        if (used_events[e] || used_truth[t]) continue;
+        used_events[e] = used_truth[t] = true;
+        matched++;
+    }
+    return matched;
+}
+
+double F1(const Score& score)
+{
+    // Nothing to find and nothing found is a perfect score.
+    if (score.predicted + score.truth == 0) return 1.0;
+    return 2.0 * score.matched / (score.predicted + score.truth);
+}
@@ -12,6 +12,16 @@ class EventTest : public CppUnit::TestFixture
     CPPUNIT_TEST(TestCheckFrame);
     CPPUNIT_TEST(TestEndEvent);
     CPPUNIT_TEST(TestGetAsJSON);
+    CPPUNIT_TEST(TestAddMeasurement);
+    CPPUNIT_TEST(TestAddDepth);
+    CPPUNIT_TEST(TestBackdateStart);
+    CPPUNIT_TEST(TestAddTrack);
+    CPPUNIT_TEST(TestAddSpeciesCandidate);
+    CPPUNIT_TEST(TestAddDetection);
+    CPPUNIT_TEST(TestGetGeoURIValues);
+    CPPUNIT_TEST(TestSummary);
+    CPPUNIT_TEST(TestValueSemantics);
+    CPPUNIT_TEST(TestMerge);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -21,6 +31,16 @@ public:
     void TestCheckFrame();
     void TestEndEvent();
     void TestGetAsJSON();
+    void TestAddMeasurement();
+    void TestAddDepth();
+    void TestBackdateStart();
+    void TestAddTrack();
+    void TestAddSpeciesCandidate();
+    void TestAddDetection();
+    void TestGetGeoURIValues();
+    void TestSummary();
+    void TestValueSemantics();
+    void TestMerge();
     
 private:
     std::unique_ptr<EventBuilder> _event;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "FileHash.h"
+
+class FileHashTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(FileHashTest);
+    CPPUNIT_TEST(TestHashFile);
+    CPPUNIT_TEST(TestHashToString);
+    CPPUNIT_TEST(TestFingerprintFile);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestHashFile();
+    void TestHashToString();
+    void TestFingerprintFile();
+
+};
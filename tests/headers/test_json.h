@@ -10,6 +10,8 @@ class JSONTest : public CppUnit::TestFixture
     CPPUNIT_TEST(TestConstructors);
     CPPUNIT_TEST(TestAddKeyValue);
     CPPUNIT_TEST(TestAddObject);
+    CPPUNIT_TEST(TestMixedObject);
+    CPPUNIT_TEST(TestAddRawValue);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -17,6 +19,8 @@ public:
     void TestConstructors();
     void TestAddKeyValue();
     void TestAddObject();
+    void TestMixedObject();
+    void TestAddRawValue();
 
 private:
     std::unique_ptr<JSON> _json;
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "MemoryBudget.h"
+
+class MemoryBudgetTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(MemoryBudgetTest);
+    CPPUNIT_TEST(TestPlanUnlimited);
+    CPPUNIT_TEST(TestPlanBudget);
+    CPPUNIT_TEST(TestPlanTooSmall);
+    CPPUNIT_TEST(TestEnforce);
+    CPPUNIT_TEST(TestResidentBytes);
+    CPPUNIT_TEST(TestFramePool);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestPlanUnlimited();
+    void TestPlanBudget();
+    void TestPlanTooSmall();
+    void TestEnforce();
+    void TestResidentBytes();
+    void TestFramePool();
+
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "Metrics.h"
+
+class MetricsTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(MetricsTest);
+    CPPUNIT_TEST(TestHistogram);
+    CPPUNIT_TEST(TestCounters);
+    CPPUNIT_TEST(TestScopedTimer);
+    CPPUNIT_TEST(TestToJSON);
+    CPPUNIT_TEST(TestMemorySample);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void TestHistogram();
+    void TestCounters();
+    void TestScopedTimer();
+    void TestToJSON();
+    void TestMemorySample();
+
+private:
+    std::unique_ptr<Metrics> _metrics;
+
+};
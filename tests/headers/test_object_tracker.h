@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "ObjectTracker.h"
+
+class ObjectTrackerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ObjectTrackerTest);
+    CPPUNIT_TEST(TestStableIds);
+    CPPUNIT_TEST(TestShortTracks);
+    CPPUNIT_TEST(TestLostTracks);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void TestStableIds();
+    void TestShortTracks();
+    void TestLostTracks();
+
+private:
+    std::unique_ptr<ObjectTracker> _tracker;
+
+};
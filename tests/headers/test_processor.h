@@ -10,6 +10,7 @@ class ProcessorTest : public CppUnit::TestFixture
     CPPUNIT_TEST(TestConstructor);
     CPPUNIT_TEST(TestProcessVideo);
     CPPUNIT_TEST(TestTriangulatePoints);
+    CPPUNIT_TEST(TestProxySize);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -17,6 +18,7 @@ public:
     void TestConstructor();
     void TestProcessVideo();
     void TestTriangulatePoints();
+    void TestProxySize();
     
 private:
     std::unique_ptr<Processor> _proc;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "SegmentWriter.h"
+
+class SegmentWriterTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(SegmentWriterTest);
+    CPPUNIT_TEST(TestSegmentName);
+    CPPUNIT_TEST(TestEmptyManifest);
+    CPPUNIT_TEST(TestWriteSegments);
+    CPPUNIT_TEST(TestUnfinished);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestSegmentName();
+    void TestEmptyManifest();
+    void TestWriteSegments();
+    void TestUnfinished();
+
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "TriangulationServer.h"
+
+class TriangulationServerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TriangulationServerTest);
+    CPPUNIT_TEST(TestConstructor);
+    CPPUNIT_TEST(TestHandleRequest);
+    CPPUNIT_TEST(TestServe);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void TestConstructor();
+    void TestHandleRequest();
+    void TestServe();
+    
+private:
+    std::unique_ptr<TriangulationServer> _server;
+
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "StringUtils.h"
+
+class StringUtilsTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(StringUtilsTest);
+    CPPUNIT_TEST(TestTrim);
+    CPPUNIT_TEST(TestFindAndSubstr);
+    CPPUNIT_TEST(TestTokenize);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestTrim();
+    void TestFindAndSubstr();
+    void TestTokenize();
+
+};
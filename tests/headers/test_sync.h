@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "SyncEngine.h"
+
+class SyncEngineTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(SyncEngineTest);
+    CPPUNIT_TEST(TestRefineOffset);
+    CPPUNIT_TEST(TestRefineFlat);
+    CPPUNIT_TEST(TestMissingVideo);
+    CPPUNIT_TEST(TestToJSON);
+    CPPUNIT_TEST(TestCache);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestRefineOffset();
+    void TestRefineFlat();
+    void TestMissingVideo();
+    void TestToJSON();
+    void TestCache();
+
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include "Thumbnails.h"
+
+class ThumbnailTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(ThumbnailTest);
+    CPPUNIT_TEST(TestStrideDoubling);
+    CPPUNIT_TEST(TestLargestObject);
+    CPPUNIT_TEST(TestClosed);
+    CPPUNIT_TEST(TestEventJSON);
+    CPPUNIT_TEST(TestWriteRename);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestStrideDoubling();
+    void TestLargestObject();
+    void TestClosed();
+    void TestEventJSON();
+    void TestWriteRename();
+
+};
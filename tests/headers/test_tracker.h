@@ -3,6 +3,8 @@
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 #include "Tracker.h"
+#include "FrameDifference.h"
+#include "RunningAverage.h"
 
 class TrackerTest : public CppUnit::TestFixture
 {
@@ -12,6 +14,15 @@ class TrackerTest : public CppUnit::TestFixture
     CPPUNIT_TEST(TestGetObjectContours);
     CPPUNIT_TEST(TestCheckForActivity);
     CPPUNIT_TEST(TestGetCascades);
+    CPPUNIT_TEST(TestBackends);
+    CPPUNIT_TEST(TestFrameDifference);
+    CPPUNIT_TEST(TestRunningAverage);
+    CPPUNIT_TEST(TestHasActivity);
+    CPPUNIT_TEST(TestDnnDetector);
+    CPPUNIT_TEST(TestFilterEvents);
+    CPPUNIT_TEST(TestSkippedFrames);
+    CPPUNIT_TEST(TestProbeFrame);
+    CPPUNIT_TEST(TestQuietSpecies);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -21,6 +32,15 @@ public:
     void TestGetObjectContours();
     void TestCheckForActivity();
     void TestGetCascades();
+    void TestBackends();
+    void TestFrameDifference();
+    void TestRunningAverage();
+    void TestHasActivity();
+    void TestDnnDetector();
+    void TestFilterEvents();
+    void TestSkippedFrames();
+    void TestProbeFrame();
+    void TestQuietSpecies();
     
 private:
     std::unique_ptr<Tracker> _tracker;
@@ -1,6 +1,8 @@
 #include "test_events.h"
 #include "JsonBuilder.h"
 
+#include <type_traits>
+
 void EventTest::setUp()
 {
     _event = std::make_unique<QREvent>();
@@ -75,4 +77,192 @@ void EventTest::TestGetAsJSON()
 
     f(new ActivityEvent(0, -1, -1), 0, 10);
     CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_0\":{\"frame_end\":10,\"frame_start\":0}}"), _event->GetAsJSON().GetJSON());
-}
\ No newline at end of file
+}
+
+void EventTest::TestAddMeasurement()
+{
+    ActivityEvent event(1, 0, -1);
+    event.AddMeasurement(400.f);
+    event.AddMeasurement(9000.f);
+    event.AddMeasurement(420.f);
+
+    int end = 10;
+    event.EndEvent(end);
+
+    // The median of all measurements is reported, ignoring the outlier.
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_1\":{\"frame_end\":10,\"frame_start\":0,\"length_mm\":420.000000,\"length_samples\":3}}"), event.GetAsJSON().GetJSON());
+}
+
+void EventTest::TestAddDepth()
+{
+    ActivityEvent event(2, 5, -1);
+    event.AddDepth(5, cv::Rect(1, 2, 3, 4), 1500.f);
+    event.AddDepth(6, cv::Rect(2, 2, 3, 4), 1400.f);
+    event.AddDepth(6, cv::Rect(40, 2, 3, 4), 900.f);
+
+    // Depths belong to the left track with their box, and the others are
+    // listed on their own.
+    ObjectTrack track;
+    track.id = 1;
+    track.camera = 0;
+    track.frame_start = 5;
+    track.frame_end = 6;
+    track.boxes = { std::make_pair(5, cv::Rect(1, 2, 3, 4)), std::make_pair(6, cv::Rect(2, 2, 3, 4)) };
+    event.AddTrack(track);
+
+    int end = 8;
+    event.EndEvent(end);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_2\":{\"depths\":[[6,40,2,3,4,900.000000]],\"frame_end\":8,"
+                                     "\"frame_start\":5,\"n_objects\":1,"
+                                     "\"tracks\":[{\"Track_1\":{\"boxes\":[[5,1,2,3,4],[6,2,2,3,4]],\"camera\":0,"
+                                     "\"depth_mm\":1500.000000,\"depth_samples\":2,\"frame_end\":6,\"frame_start\":5}}]}}"),
+                         event.GetAsJSON().GetJSON());
+    CPPUNIT_ASSERT_EQUAL((size_t)3, event.Summary().depth_samples);
+}
+
+void EventTest::TestBackdateStart()
+{
+    ActivityEvent event(1, 20, -1);
+
+    // Only earlier, valid frames move the start.
+    event.BackdateStart(25);
+    event.BackdateStart(-1);
+    CPPUNIT_ASSERT_EQUAL(20, event.GetRange().first);
+
+    event.BackdateStart(16);
+    CPPUNIT_ASSERT_EQUAL(16, event.GetRange().first);
+    CPPUNIT_ASSERT(event.IsActive());
+}
+
+void EventTest::TestAddTrack()
+{
+    ActivityEvent event(1, 3, -1);
+
+    ObjectTrack track;
+    track.id = 1;
+    track.camera = 0;
+    track.frame_start = 3;
+    track.frame_end = 4;
+    track.boxes = { std::make_pair(3, cv::Rect(1, 2, 3, 4)), std::make_pair(4, cv::Rect(2, 2, 3, 4)) };
+    event.AddTrack(track);
+
+    int end = 5;
+    event.EndEvent(end);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_1\":{\"frame_end\":5,\"frame_start\":3,\"n_objects\":1,"
+                                     "\"tracks\":[{\"Track_1\":{\"boxes\":[[3,1,2,3,4],[4,2,2,3,4]],"
+                                     "\"camera\":0,\"frame_end\":4,\"frame_start\":3}}]}}"),
+                         event.GetAsJSON().GetJSON());
+}
+
+void EventTest::TestAddSpeciesCandidate()
+{
+    ActivityEvent event(3, 0, -1);
+    event.AddSpeciesCandidate("cod");
+    event.AddSpeciesCandidate("salmon");
+    event.AddSpeciesCandidate("cod");
+
+    int end = 4;
+    event.EndEvent(end);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_3\":{\"frame_end\":4,\"frame_start\":0,"
+                                     "\"species\":{\"cod\":2,\"salmon\":1}}}"),
+                         event.GetAsJSON().GetJSON());
+}
+
+void EventTest::TestAddDetection()
+{
+    ActivityEvent event(2, 6, -1);
+    event.AddDetection(Detection{ 7, 1, 3, 0.75f, cv::Rect(10, 20, 30, 40) });
+
+    int end = 8;
+    event.EndEvent(end);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_2\":{\"detections\":[[7,1,3,0.750000,10,20,30,40]],"
+                                     "\"frame_end\":8,\"frame_start\":6}}"),
+                         event.GetAsJSON().GetJSON());
+}
+
+void EventTest::TestGetGeoURIValues()
+{
+    auto values = QREvent::GetGeoURIValues(" geo:49.2827, -123.1207;u=35 ; crs = wgs84");
+    CPPUNIT_ASSERT_EQUAL((size_t)4, values.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("49.2827"), values["lat"]);
+    CPPUNIT_ASSERT_EQUAL(std::string("-123.1207"), values["long"]);
+    CPPUNIT_ASSERT_EQUAL(std::string("35"), values["u"]);
+    CPPUNIT_ASSERT_EQUAL(std::string("wgs84"), values["crs"]);
+
+    // Payloads which are not geo URIs give nothing.
+    CPPUNIT_ASSERT(QREvent::GetGeoURIValues("").empty());
+    CPPUNIT_ASSERT(QREvent::GetGeoURIValues("https://example.com").empty());
+}
+
+void EventTest::TestSummary()
+{
+    ActivityEvent event(4, 10, -1);
+    event.AddMeasurement(400.f);
+    event.AddMeasurement(420.f);
+    event.AddMeasurement(900.f);
+
+    ObjectTrack track;
+    track.id = 1;
+    track.camera = 1;
+    track.frame_start = 10;
+    track.frame_end = 11;
+    track.boxes = { std::make_pair(10, cv::Rect(0, 0, 10, 10)), std::make_pair(11, cv::Rect(5, 5, 10, 10)) };
+    event.AddTrack(track);
+
+    int end = 12;
+    event.EndEvent(end);
+
+    ActivitySummary summary = event.Summary();
+    CPPUNIT_ASSERT_EQUAL(4, summary.id);
+    CPPUNIT_ASSERT_EQUAL(10, summary.frame_start);
+    CPPUNIT_ASSERT_EQUAL(12, summary.frame_end);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(420.0, summary.length_mm, 1e-6);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, summary.length_samples);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, summary.depth_samples);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, summary.n_objects);
+    CPPUNIT_ASSERT(summary.bounds[0].empty());
+    CPPUNIT_ASSERT(summary.bounds[1] == cv::Rect(0, 0, 15, 15));
+}
+
+void EventTest::TestValueSemantics()
+{
+    // Events are moved rather than copied when their vector grows.
+    CPPUNIT_ASSERT(std::is_nothrow_move_constructible<ActivityEvent>::value);
+
+    std::vector<ActivityEvent> events;
+    events.emplace_back(1, 0, -1);
+    events.back().AddMeasurement(300.f);
+    int end = 4;
+    events.back().EndEvent(end);
+    std::string json = events.back().GetAsJSON().GetJSON();
+
+    for(int i = 2; i <= 100; i++)
+        events.emplace_back(i, i * 10, i * 10 + 5);
+    CPPUNIT_ASSERT_EQUAL(json, events.front().GetAsJSON().GetJSON());
+    CPPUNIT_ASSERT_EQUAL(1000, events.back().GetRange().first);
+    CPPUNIT_ASSERT_EQUAL(1005, events.back().GetRange().second);
+}
+
+void EventTest::TestMerge()
+{
+    ActivityEvent first(1, 10, 20), second(2, 24, 30);
+    first.AddMeasurement(300.f);
+    first.AddSpeciesCandidate("cod");
+    second.AddMeasurement(500.f);
+    second.AddMeasurement(400.f);
+    second.AddSpeciesCandidate("cod");
+
+    first.Merge(std::move(second));
+    CPPUNIT_ASSERT_EQUAL(10, first.GetRange().first);
+    CPPUNIT_ASSERT_EQUAL(30, first.GetRange().second);
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_1\":{\"frame_end\":30,\"frame_start\":10,"
+                                     "\"length_mm\":400.000000,\"length_samples\":3,\"species\":{\"cod\":2}}}"),
+                         first.GetAsJSON().GetJSON());
+
+    // The absorbed event keeps nothing.
+    CPPUNIT_ASSERT_EQUAL(std::string("{}"), second.GetAsJSON().GetJSON());
+}
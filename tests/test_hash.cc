@@ -0,0 +1,55 @@
+#include "test_hash.h"
+
+#include <cstdio>
+#include <fstream>
+
+void FileHashTest::TestHashFile()
+{
+    std::string path = "test_hash.tmp";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "goFish";
+    }
+
+    CPPUNIT_ASSERT_EQUAL(std::string("f6444eb3fe81ddd9"), HashToString(HashFile(path)));
+    std::remove(path.c_str());
+
+    // Missing files hash to 0.
+    CPPUNIT_ASSERT(HashFile("missing_file.tmp") == 0);
+}
+
+void FileHashTest::TestHashToString()
+{
+    CPPUNIT_ASSERT_EQUAL(std::string("0000000000000000"), HashToString(0));
+    CPPUNIT_ASSERT_EQUAL(std::string("00000000000000ff"), HashToString(255));
+}
+
+void FileHashTest::TestFingerprintFile()
+{
+    std::string path = "test_fingerprint.tmp";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(3 << 20, 'a');
+    }
+    uint64_t fingerprint = FingerprintFile(path);
+    CPPUNIT_ASSERT(fingerprint != 0);
+
+    // Bytes between the head and the tail are not read.
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(3 << 19);
+        file << 'b';
+    }
+    CPPUNIT_ASSERT(FingerprintFile(path) == fingerprint);
+
+    // But the last byte is.
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp((3 << 20) - 1);
+        file << 'b';
+    }
+    CPPUNIT_ASSERT(FingerprintFile(path) != fingerprint);
+    std::remove(path.c_str());
+
+    CPPUNIT_ASSERT(FingerprintFile("missing_file.tmp") == 0);
+}
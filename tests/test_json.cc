@@ -79,4 +79,42 @@ void JSONTest::TestAddObject()
     _json.reset(j2);
     _json->BuildJSONObjectArray();
     CPPUNIT_ASSERT_EQUAL(_json->GetJSON(), std::string("{\"json2\":[{\"sub1\":\"val1\"}]}"));
-}
\ No newline at end of file
+}
+
+void JSONTest::TestMixedObject()
+{
+    std::string name = "json";
+    auto j = new JSON(name);
+    _json.reset(j);
+
+    std::map<std::string, std::string> val;
+    val.insert(std::make_pair("sub1", "val1"));
+
+    _json->AddKeyValue("key", "1");
+    _json->AddObject(JSON("json2", val));
+
+    // Key value pairs and objects must be separated.
+    _json->BuildJSONObject();
+    CPPUNIT_ASSERT_EQUAL(_json->GetJSON(), "{\"" + name + "\":{\"key\":1,\"json2\":{\"sub1\":\"val1\"}}}");
+
+    _json->BuildJSONObjectArray();
+    CPPUNIT_ASSERT_EQUAL(_json->GetJSON(), "{\"" + name + "\":[{\"key\":1},{\"json2\":{\"sub1\":\"val1\"}}]}");
+}
+
+void JSONTest::TestAddRawValue()
+{
+    std::string name = "json";
+    auto j = new JSON(name);
+    _json.reset(j);
+
+    _json->AddRawValue("raw", "[[1,2],[3,4]]");
+    _json->AddKeyValue("str", "[1]");
+
+    // Only raw values are left unquoted.
+    _json->BuildJSONObject();
+    CPPUNIT_ASSERT_EQUAL(_json->GetJSON(), "{\"" + name + "\":{\"raw\":[[1,2],[3,4]],\"str\":\"[1]\"}}");
+
+    JSON copy(*_json);
+    copy.BuildJSONObject();
+    CPPUNIT_ASSERT_EQUAL(_json->GetJSON(), copy.GetJSON());
+}
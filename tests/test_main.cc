@@ -4,6 +4,15 @@
 #include "test_json.h"
 #include "test_events.h"
 #include "test_calibration.h"
+#include "test_server.h"
+#include "test_hash.h"
+#include "test_object_tracker.h"
+#include "test_metrics.h"
+#include "test_sync.h"
+#include "test_strings.h"
+#include "test_thumbnails.h"
+#include "test_segments.h"
+#include "test_memory.h"
 
 using namespace CppUnit;
 
@@ -15,6 +24,15 @@ int main()
    runner.addTest(EventTest::suite());
    runner.addTest(TrackerTest::suite());
    runner.addTest(ProcessorTest::suite());
+   runner.addTest(TriangulationServerTest::suite());
+   runner.addTest(FileHashTest::suite());
+   runner.addTest(ObjectTrackerTest::suite());
+   runner.addTest(MetricsTest::suite());
+   runner.addTest(SyncEngineTest::suite());
+   runner.addTest(StringUtilsTest::suite());
+   runner.addTest(ThumbnailTest::suite());
+   runner.addTest(SegmentWriterTest::suite());
+   runner.addTest(MemoryBudgetTest::suite());
    runner.run();
    
    return 0;
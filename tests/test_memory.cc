@@ -0,0 +1,123 @@
+#include "test_memory.h"
+
+void MemoryBudgetTest::TestPlanUnlimited()
+{
+    MemoryBudget budget{ MemoryBudget::Settings() };
+    CPPUNIT_ASSERT(!budget.IsLimited());
+
+    MemoryPlan plan = budget.Plan(cv::Size(1920, 1440), 29, 8, (size_t)6 << 30);
+    CPPUNIT_ASSERT(plan.fits);
+    CPPUNIT_ASSERT_EQUAL(29, plan.queue_depth);
+    CPPUNIT_ASSERT_EQUAL(62, plan.pool_frames);
+    CPPUNIT_ASSERT_EQUAL(8, plan.threads);
+
+    // Nothing is ever over an unlimited budget.
+    CPPUNIT_ASSERT(!budget.Enforce(plan, (size_t)6 << 30));
+}
+
+void MemoryBudgetTest::TestPlanBudget()
+{
+    MemoryBudget::Settings settings;
+    settings.BudgetMB = 100;
+    MemoryBudget budget(settings);
+
+    // 50 MB are left for 921600 byte frames, 13 of which are always needed.
+    MemoryPlan plan = budget.Plan(cv::Size(640, 480), 29, 4, (size_t)50 << 20);
+    CPPUNIT_ASSERT(plan.fits);
+    CPPUNIT_ASSERT_EQUAL(4, plan.threads);
+    CPPUNIT_ASSERT_EQUAL(20, plan.queue_depth);
+    CPPUNIT_ASSERT_EQUAL(44, plan.pool_frames);
+
+    // Nothing more is held than striding needs.
+    plan = budget.Plan(cv::Size(640, 480), 3, 4, (size_t)50 << 20);
+    CPPUNIT_ASSERT_EQUAL(3, plan.queue_depth);
+}
+
+void MemoryBudgetTest::TestPlanTooSmall()
+{
+    MemoryBudget::Settings settings;
+    settings.BudgetMB = 10;
+    MemoryBudget budget(settings);
+
+    MemoryPlan plan = budget.Plan(cv::Size(640, 480), 29, 4, (size_t)5 << 20);
+    CPPUNIT_ASSERT(!plan.fits);
+    CPPUNIT_ASSERT_EQUAL(0, plan.queue_depth);
+    CPPUNIT_ASSERT_EQUAL(1, plan.threads);
+}
+
+void MemoryBudgetTest::TestEnforce()
+{
+    MemoryBudget::Settings settings;
+    settings.BudgetMB = 100;
+    MemoryBudget budget(settings);
+
+    MemoryPlan plan;
+    plan.queue_depth = 20;
+    plan.pool_frames = 44;
+    plan.threads = 4;
+    CPPUNIT_ASSERT(!budget.Enforce(plan, (size_t)90 << 20));
+    CPPUNIT_ASSERT_EQUAL(20, plan.queue_depth);
+
+    CPPUNIT_ASSERT(budget.Enforce(plan, (size_t)120 << 20));
+    CPPUNIT_ASSERT_EQUAL(10, plan.queue_depth);
+    CPPUNIT_ASSERT_EQUAL(24, plan.pool_frames);
+    CPPUNIT_ASSERT_EQUAL(2, plan.threads);
+
+    // The plan stops shrinking once nothing is left to give up.
+    int shrinks = 0;
+    while(budget.Enforce(plan, (size_t)120 << 20))
+        shrinks++;
+    CPPUNIT_ASSERT_EQUAL(4, shrinks);
+    CPPUNIT_ASSERT_EQUAL(0, plan.queue_depth);
+    CPPUNIT_ASSERT_EQUAL(4, plan.pool_frames);
+    CPPUNIT_ASSERT_EQUAL(1, plan.threads);
+}
+
+void MemoryBudgetTest::TestResidentBytes()
+{
+    size_t rss = MemoryBudget::ResidentBytes();
+    CPPUNIT_ASSERT(rss > 0);
+    CPPUNIT_ASSERT(MemoryBudget::PeakResidentBytes() >= rss);
+}
+
+void MemoryBudgetTest::TestFramePool()
+{
+    FramePool pool(2);
+    uchar* data = nullptr;
+    {
+        auto frame = pool.Acquire();
+        frame->create(48, 64, CV_8UC3);
+        data = frame->data;
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)1, pool.Available());
+
+    // The buffer is handed out again.
+    auto reused = pool.Acquire();
+    CPPUNIT_ASSERT(reused->data == data);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, pool.Available());
+
+    // But not while its image is still shared.
+    cv::Mat shared = *reused;
+    reused.reset();
+    CPPUNIT_ASSERT(shared.data == data);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, pool.Available());
+
+    // No more than the capacity is kept.
+    {
+        std::shared_ptr<cv::Mat> frames[3] = { pool.Acquire(), pool.Acquire(), pool.Acquire() };
+        for(auto& frame : frames)
+            frame->create(48, 64, CV_8UC3);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)2, pool.Available());
+    pool.SetCapacity(1);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, pool.Available());
+
+    // Frames can outlive their pool.
+    std::shared_ptr<cv::Mat> orphan;
+    {
+        FramePool temporary(1);
+        orphan = temporary.Acquire();
+        orphan->create(48, 64, CV_8UC3);
+    }
+    orphan.reset();
+}
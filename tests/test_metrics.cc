@@ -0,0 +1,102 @@
+#include "test_metrics.h"
+
+
+void MetricsTest::setUp()
+{
+    _metrics = std::make_unique<Metrics>();
+}
+
+void MetricsTest::TestHistogram()
+{
+    for(double ms : { 0.05, 0.3, 0.4, 3.0, 2000.0 })
+        _metrics->AddSample("decode", ms);
+
+    auto hist = _metrics->GetStage("decode");
+    CPPUNIT_ASSERT(hist != nullptr);
+    CPPUNIT_ASSERT(_metrics->GetStage("encode") == nullptr);
+
+    CPPUNIT_ASSERT_EQUAL(5L, hist->count);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.05, hist->min_ms, 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2000.0, hist->max_ms, 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(400.75, hist->Mean(), 1e-9);
+
+    // One slot per bound, plus one for anything slower than the last.
+    CPPUNIT_ASSERT_EQUAL(Metrics::BucketBounds().size() + 1, hist->buckets.size());
+    CPPUNIT_ASSERT_EQUAL(1L, hist->buckets.front());
+    CPPUNIT_ASSERT_EQUAL(1L, hist->buckets.back());
+
+    // The median falls in the (0.25, 0.5] bucket.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, hist->Percentile(0.5), 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2000.0, hist->Percentile(0.95), 1e-9);
+}
+
+void MetricsTest::TestCounters()
+{
+    CPPUNIT_ASSERT_EQUAL(0L, _metrics->GetCounter("frames"));
+
+    _metrics->Increment("frames");
+    _metrics->Increment("frames");
+    _metrics->Increment("frames_dropped", 3);
+    CPPUNIT_ASSERT_EQUAL(2L, _metrics->GetCounter("frames"));
+    CPPUNIT_ASSERT_EQUAL(3L, _metrics->GetCounter("frames_dropped"));
+}
+
+void MetricsTest::TestScopedTimer()
+{
+    {
+        Metrics::ScopedTimer timer(_metrics.get(), "encode");
+    }
+    {
+        // Timing without metrics does nothing.
+        Metrics::ScopedTimer timer(nullptr, "encode");
+    }
+
+    auto hist = _metrics->GetStage("encode");
+    CPPUNIT_ASSERT(hist != nullptr);
+    CPPUNIT_ASSERT_EQUAL(1L, hist->count);
+    CPPUNIT_ASSERT(hist->total_ms >= 0.0);
+}
+
+void MetricsTest::TestToJSON()
+{
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Metrics\":{\"buckets_ms\":[0.1,0.25,0.5,1,2.5,5,10,25,50,100,250,500,1000],"
+                                     "\"counters\":{},\"stages_ms\":{}}}"),
+                         _metrics->ToJSON().GetJSON());
+
+    _metrics->AddSample("qr", 2.0);
+    _metrics->Increment("events", 2);
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Metrics\":{\"buckets_ms\":[0.1,0.25,0.5,1,2.5,5,10,25,50,100,250,500,1000],"
+                                     "\"counters\":{\"events\":2},"
+                                     "\"stages_ms\":{\"qr\":{\"count\":1,\"histogram\":[0,0,0,0,1,0,0,0,0,0,0,0,0,0],"
+                                     "\"max\":2.000000,\"mean\":2.000000,\"min\":2.000000,\"p50\":2.000000,"
+                                     "\"p95\":2.000000,\"total\":2.000000}}}}"),
+                         _metrics->ToJSON().GetJSON());
+}
+
+void MetricsTest::TestMemorySample()
+{
+    _metrics->AddSample("decode", 2.0);
+    _metrics->AddMemorySample("decode", 3 << 20);
+    _metrics->AddMemorySample("decode", 2 << 20);
+    CPPUNIT_ASSERT_EQUAL((size_t)(3 << 20), _metrics->GetStage("decode")->process_rss);
+    CPPUNIT_ASSERT(_metrics->ToJSON().GetJSON().find("\"process_rss_mb\":3.000000") != std::string::npos);
+
+    // Timed stages only sample memory while sampling is on.
+    {
+        Metrics::ScopedTimer timer(_metrics.get(), "subtract");
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)0, _metrics->GetStage("subtract")->process_rss);
+
+    _metrics->SetMemorySampling(true);
+    {
+        Metrics::ScopedTimer timer(_metrics.get(), "subtract");
+    }
+    CPPUNIT_ASSERT(_metrics->GetStage("subtract")->process_rss > 0);
+
+    // Gauges hold the last value instead of adding up.
+    _metrics->SetGauge("process_rss_peak_mb", 5.0);
+    _metrics->SetGauge("process_rss_peak_mb", 4.0);
+    CPPUNIT_ASSERT_EQUAL(4.0, _metrics->GetGauge("process_rss_peak_mb"));
+    CPPUNIT_ASSERT_EQUAL(0L, _metrics->GetCounter("process_rss_peak_mb"));
+    CPPUNIT_ASSERT(_metrics->ToJSON().GetJSON().find("\"gauges\":{\"process_rss_peak_mb\":4.000000}") != std::string::npos);
+}
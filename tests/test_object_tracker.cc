@@ -0,0 +1,63 @@
+#include "test_object_tracker.h"
+
+
+void ObjectTrackerTest::setUp()
+{
+    ObjectTracker::Settings config;
+    config.MaxMissed = 5;
+    config.MinHits = 3;
+    _tracker = std::make_unique<ObjectTracker>(config, 1);
+}
+
+void ObjectTrackerTest::TestStableIds()
+{
+    // Two fish swimming in opposite directions.
+    for(int frame = 0; frame < 10; frame++)
+        _tracker->Update({ cv::Rect(100 + 2 * frame, 50, 40, 20), cv::Rect(400 - 3 * frame, 200, 60, 30) }, frame);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), _tracker->ActiveTracks());
+
+    auto tracks = _tracker->Flush();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), tracks.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(0), _tracker->ActiveTracks());
+
+    for(int i = 0; i < 2; i++)
+    {
+        CPPUNIT_ASSERT_EQUAL(i + 1, tracks[i].id);
+        CPPUNIT_ASSERT_EQUAL(1, tracks[i].camera);
+        CPPUNIT_ASSERT_EQUAL(0, tracks[i].frame_start);
+        CPPUNIT_ASSERT_EQUAL(9, tracks[i].frame_end);
+        CPPUNIT_ASSERT_EQUAL(size_t(10), tracks[i].boxes.size());
+    }
+    CPPUNIT_ASSERT_EQUAL(118, tracks[0].boxes.back().second.x);
+    CPPUNIT_ASSERT_EQUAL(373, tracks[1].boxes.back().second.x);
+}
+
+void ObjectTrackerTest::TestShortTracks()
+{
+    // Objects seen in fewer than MinHits frames are noise.
+    _tracker->Update({ cv::Rect(10, 10, 20, 20) }, 0);
+    _tracker->Update({ cv::Rect(10, 10, 20, 20) }, 1);
+    CPPUNIT_ASSERT(_tracker->Flush().empty());
+}
+
+void ObjectTrackerTest::TestLostTracks()
+{
+    cv::Rect box(10, 10, 20, 20);
+    for(int frame = 0; frame < 5; frame++)
+        _tracker->Update({ box }, frame);
+
+    // Missing for more than MaxMissed frames finishes the track...
+    for(int frame = 5; frame < 11; frame++)
+        _tracker->Update({}, frame);
+    CPPUNIT_ASSERT_EQUAL(size_t(0), _tracker->ActiveTracks());
+
+    // ...so the object comes back as a new one.
+    for(int frame = 11; frame < 14; frame++)
+        _tracker->Update({ box }, frame);
+
+    auto tracks = _tracker->Flush();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), tracks.size());
+    CPPUNIT_ASSERT_EQUAL(4, tracks[0].frame_end);
+    CPPUNIT_ASSERT_EQUAL(2, tracks[1].id);
+    CPPUNIT_ASSERT_EQUAL(11, tracks[1].frame_start);
+}
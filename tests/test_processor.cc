@@ -1,5 +1,7 @@
 #include "test_processor.h"
 
+#include <opencv2/opencv.hpp>
+
 void ProcessorTest::setUp()
 {
     _proc = std::make_unique<Processor>();
@@ -20,3 +22,15 @@ void ProcessorTest::TestTriangulatePoints()
 {
     _proc->TriangulatePoints("../calib_config/measure_points.yaml", "../calib_config/stereo_calibration.yaml");
 }
+
+void ProcessorTest::TestProxySize()
+{
+    CPPUNIT_ASSERT(Processor::GetProxySize(cv::Size(3840, 1440), 960) == cv::Size(960, 360));
+
+    // Dimensions are kept even.
+    CPPUNIT_ASSERT(Processor::GetProxySize(cv::Size(1000, 333), 501) == cv::Size(500, 166));
+
+    // No proxy when disabled, or when it would not be smaller.
+    CPPUNIT_ASSERT(Processor::GetProxySize(cv::Size(3840, 1440), 0).empty());
+    CPPUNIT_ASSERT(Processor::GetProxySize(cv::Size(1280, 480), 1280).empty());
+}
@@ -0,0 +1,108 @@
+#include "test_segments.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <opencv2/core/utils/filesystem.hpp>
+
+std::string ReadFile(const std::string& path);
+
+void SegmentWriterTest::TestSegmentName()
+{
+    CPPUNIT_ASSERT_EQUAL(std::string("fish_000.mp4"), SegmentWriter::SegmentName("fish", 0, ".mp4"));
+    CPPUNIT_ASSERT_EQUAL(std::string("fish_042.avi"), SegmentWriter::SegmentName("fish", 42, ".avi"));
+    CPPUNIT_ASSERT_EQUAL(std::string("fish_1234.mp4"), SegmentWriter::SegmentName("fish", 1234, ".mp4"));
+}
+
+void SegmentWriterTest::TestEmptyManifest()
+{
+    std::string dir = "test_segments_empty";
+    SegmentWriter writer(dir, "empty", cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, cv::Size(64, 48),
+                         SegmentWriter::Settings());
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Manifest\":{\"complete\":false,\"fps\":30.000000,\"frames\":0,\"segments\":[]}}"),
+                         writer.ToJSON().GetJSON());
+
+    // Closing a video without frames still leaves a complete manifest.
+    writer.Close();
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Manifest\":{\"complete\":true,\"fps\":30.000000,\"frames\":0,\"segments\":[]}}"),
+                         ReadFile(writer.GetManifestPath()));
+    cv::utils::fs::remove_all(dir);
+}
+
+void SegmentWriterTest::TestWriteSegments()
+{
+    std::string dir = "test_segments";
+    SegmentWriter::Settings settings;
+    settings.SegmentFrames = 10;
+    settings.Extension = ".avi";
+    SegmentWriter writer(dir, "clip", cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, cv::Size(64, 48), settings);
+
+    cv::Mat frame(48, 64, CV_8UC3, cv::Scalar(40, 80, 120));
+    for(int i = 0; i < 15; i++)
+        writer.Write(frame);
+
+    // Only finished segments are listed, as the manifest is only replaced
+    // when a segment finishes.
+    CPPUNIT_ASSERT_EQUAL((size_t)1, writer.GetSegments().size());
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Manifest\":{\"complete\":false,\"fps\":30.000000,\"frames\":10,\"segments\":"
+                                     "[{\"Segment_0\":{\"file\":\"clip_000.avi\",\"frame_start\":0,\"frames\":10}}]}}"),
+                         ReadFile(writer.GetManifestPath()));
+
+    for(int i = 0; i < 10; i++)
+        writer.Write(frame);
+    writer.Close();
+
+    auto& segments = writer.GetSegments();
+    CPPUNIT_ASSERT_EQUAL((size_t)3, segments.size());
+    CPPUNIT_ASSERT_EQUAL(20, segments[2].frame_start);
+    CPPUNIT_ASSERT_EQUAL(5, segments[2].frames);
+    for(auto& segment : segments)
+    {
+        cv::VideoCapture cap(cv::utils::fs::join(dir, segment.file));
+        CPPUNIT_ASSERT(cap.isOpened());
+        CPPUNIT_ASSERT_EQUAL(segment.frames, (int)cap.get(cv::CAP_PROP_FRAME_COUNT));
+    }
+    CPPUNIT_ASSERT(ReadFile(writer.GetManifestPath()).find("\"complete\":true") != std::string::npos);
+
+    // Frames after closing are ignored.
+    writer.Write(frame);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, writer.GetSegments().size());
+    cv::utils::fs::remove_all(dir);
+}
+
+void SegmentWriterTest::TestUnfinished()
+{
+    std::string dir = "test_segments_unfinished", manifest;
+    {
+        SegmentWriter::Settings settings;
+        settings.SegmentFrames = 10;
+        settings.Extension = ".avi";
+        SegmentWriter writer(dir, "clip", cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, cv::Size(64, 48), settings);
+        manifest = writer.GetManifestPath();
+
+        cv::Mat frame(48, 64, CV_8UC3, cv::Scalar(40, 80, 120));
+        for(int i = 0; i < 15; i++)
+            writer.Write(frame);
+    }
+
+    // A writer dropped without closing, e.g. while unwinding an error, lists
+    // the segment it had open but never marks the video complete.
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Manifest\":{\"complete\":false,\"fps\":30.000000,\"frames\":15,\"segments\":"
+                                     "[{\"Segment_0\":{\"file\":\"clip_000.avi\",\"frame_start\":0,\"frames\":10}},"
+                                     "{\"Segment_1\":{\"file\":\"clip_001.avi\",\"frame_start\":10,\"frames\":5}}]}}"),
+                         ReadFile(manifest));
+    cv::utils::fs::remove_all(dir);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+std::string ReadFile(const std::string& path)
+{
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
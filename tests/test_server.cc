@@ -0,0 +1,45 @@
+#include "test_server.h"
+#include "Calibration.h"
+
+#include <algorithm>
+#include <sstream>
+
+void TriangulationServerTest::setUp()
+{
+    Calibration::Input input;
+    input.image_size = cv::Size(1920, 1440);
+    auto calib = std::make_shared<Calibration>(input, CalibrationType::STEREO, "stereo_calibration.yaml");
+    _server = std::make_unique<TriangulationServer>(calib);
+}
+
+void TriangulationServerTest::TestConstructor()
+{
+    CPPUNIT_ASSERT_THROW(TriangulationServer(nullptr), std::runtime_error);
+}
+
+void TriangulationServerTest::TestHandleRequest()
+{
+    // Malformed requests are rejected before reaching the calibration.
+    CPPUNIT_ASSERT(_server->HandleRequest("1 2 3").find("\"Error\"") != std::string::npos);
+    CPPUNIT_ASSERT(_server->HandleRequest("1 2 a 4").find("\"Error\"") != std::string::npos);
+
+    // No calibration has been read, so there is nothing to triangulate with.
+    std::string response = _server->HandleRequest("1,2,3,4");
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Error\":\"No stereo projection matrices loaded!\",\"latency_us\":"),
+                         response.substr(0, response.find(':', response.find("latency_us")) + 1));
+    CPPUNIT_ASSERT_EQUAL('}', response.back());
+
+    // Every response carries its latency.
+    CPPUNIT_ASSERT(_server->HandleRequest("1 2 3").find("\"latency_us\":") != std::string::npos);
+}
+
+void TriangulationServerTest::TestServe()
+{
+    std::istringstream in("1 2 3\n\n1 2 3 4\n");
+    std::ostringstream out;
+    _server->Serve(in, out);
+
+    // One response line per non-empty request line.
+    std::string response = out.str();
+    CPPUNIT_ASSERT_EQUAL(2l, (long)std::count(response.begin(), response.end(), '\n'));
+}
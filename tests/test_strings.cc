@@ -0,0 +1,42 @@
+#include "test_strings.h"
+
+void StringUtilsTest::TestTrim()
+{
+    std::string str = " \t geo:49.2827 \n";
+    StringSlice trimmed = StringSlice(str).Trim();
+    CPPUNIT_ASSERT_EQUAL(std::string("geo:49.2827"), trimmed.ToString());
+
+    // The slice points into the original string.
+    CPPUNIT_ASSERT(trimmed.Data() == str.data() + 3);
+
+    CPPUNIT_ASSERT(StringSlice(std::string("   ")).Trim().Empty());
+}
+
+void StringUtilsTest::TestFindAndSubstr()
+{
+    std::string str = "u=35;geo:1,2";
+    StringSlice slice(str);
+    CPPUNIT_ASSERT_EQUAL((size_t)5, slice.Find("geo:"));
+    CPPUNIT_ASSERT(slice.Find("crs=") == std::string::npos);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("1,2"), slice.Substr(9).ToString());
+    CPPUNIT_ASSERT_EQUAL(std::string("u=35"), slice.Substr(0, 4).ToString());
+    CPPUNIT_ASSERT(slice.Substr(100).Empty());
+}
+
+void StringUtilsTest::TestTokenize()
+{
+    std::string str = " 49.2827 ,, -123.1207 ,";
+    auto tokens = Tokenize(str, ',');
+
+    // Empty tokens in the middle are kept, but not a trailing one.
+    CPPUNIT_ASSERT_EQUAL((size_t)3, tokens.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("49.2827"), tokens[0].ToString());
+    CPPUNIT_ASSERT(tokens[1].Empty());
+    CPPUNIT_ASSERT(tokens[2] == StringSlice(std::string("-123.1207")));
+
+    CPPUNIT_ASSERT(Tokenize(std::string(""), ',').empty());
+
+    std::string path = "calib_images/left/";
+    CPPUNIT_ASSERT_EQUAL(std::string("left"), Tokenize(path, '/').back().ToString());
+}
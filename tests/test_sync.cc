@@ -0,0 +1,130 @@
+#include "test_sync.h"
+#include "JsonBuilder.h"
+
+#include <cmath>
+#include <cstdio>
+
+std::vector<double> Pulse(double centre);
+
+void SyncEngineTest::TestRefineOffset()
+{
+    double confidence = 0.0;
+
+    // The right video sees the same pulse three frames later.
+    double correction = SyncEngine::RefineOffset(Pulse(40), Pulse(43), 0, 5, confidence);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, correction, 0.05);
+    CPPUNIT_ASSERT(confidence > 0.99);
+
+    // Half a frame is found from the neighbouring correlations.
+    correction = SyncEngine::RefineOffset(Pulse(40), Pulse(42.5), 1, 3, confidence);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5, correction, 0.1);
+}
+
+void SyncEngineTest::TestRefineFlat()
+{
+    // Without any change in brightness the estimate stays as it is.
+    double confidence = 1.0;
+    std::vector<double> flat(120, 80.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, SyncEngine::RefineOffset(flat, flat, 2, 3, confidence), 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, confidence, 1e-9);
+}
+
+void SyncEngineTest::TestMissingVideo()
+{
+    SyncEngine engine{ SyncEngine::Settings() };
+    CPPUNIT_ASSERT_THROW(engine.Sync("missing_left.mp4", "missing_right.mp4"), std::runtime_error);
+}
+
+void SyncEngineTest::TestToJSON()
+{
+    SyncResult result;
+    result.found = true;
+    result.qr_first[0] = 10; result.qr_last[0] = 20;
+    result.qr_first[1] = 13; result.qr_last[1] = 22;
+    result.offset = 3;
+    result.start[0] = 21; result.start[1] = 24;
+    result.url = "geo:49.2827,-123.1207";
+
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_QRCode\":{\"frame\":10,\"lat\":49.2827,\"long\":-123.1207,"
+                                     "\"offset_confidence\":0.000000,\"offset_frames\":3,\"offset_refinement\":0.000000,"
+                                     "\"qr_first_left\":10,\"qr_first_right\":13,\"qr_last_left\":20,\"qr_last_right\":22,"
+                                     "\"start_left\":21,\"start_right\":24}}"),
+                         result.ToJSON().GetJSON());
+}
+
+void SyncEngineTest::TestCache()
+{
+    std::string path = "test_sync_cache.yaml";
+    SyncEngine::Settings settings;
+
+    SyncResult result;
+    result.found = true;
+    result.qr_first[0] = 4; result.qr_last[0] = 9;
+    result.qr_first[1] = 6; result.qr_last[1] = 12;
+    result.offset = 2;
+    result.refinement = 0.25;
+    result.confidence = 0.9;
+    result.start[0] = 11; result.start[1] = 13;
+    result.url = "geo:49.2827,-123.1207";
+    {
+        SyncCache cache(path, settings);
+        cache.Store(0xabc, 0xdef, result);
+        cache.Write();
+    }
+
+    SyncResult cached;
+    SyncCache cache(path, settings);
+    CPPUNIT_ASSERT(!cache.Find(0xdef, 0xabc, cached));
+    CPPUNIT_ASSERT(cache.Find(0xabc, 0xdef, cached));
+    CPPUNIT_ASSERT(cached.found);
+    CPPUNIT_ASSERT_EQUAL(2, cached.offset);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, cached.refinement, 1e-9);
+    CPPUNIT_ASSERT_EQUAL(13, cached.start[1]);
+    CPPUNIT_ASSERT_EQUAL(result.ToJSON().GetJSON(), cached.ToJSON().GetJSON());
+
+    // Pairs cached by another process since this cache was read are kept.
+    {
+        SyncCache other(path, settings);
+        other.Store(0x123, 0x456, result);
+        cache.Store(0x789, 0xabc, result);
+        other.Write();
+        cache.Write();
+    }
+    SyncCache merged(path, settings);
+    CPPUNIT_ASSERT(merged.Find(0xabc, 0xdef, cached));
+    CPPUNIT_ASSERT(merged.Find(0x123, 0x456, cached));
+    CPPUNIT_ASSERT(merged.Find(0x789, 0xabc, cached));
+
+    // Results found with any other settings are not reused.
+    SyncEngine::Settings other = settings;
+    other.MaxSearchFrames = 300;
+    CPPUNIT_ASSERT(!SyncCache(path, other).Find(0xabc, 0xdef, cached));
+    other = settings;
+    other.MaxQRGap = 5;
+    CPPUNIT_ASSERT(!SyncCache(path, other).Find(0xabc, 0xdef, cached));
+    other = settings;
+    other.RefineFrames = 30;
+    CPPUNIT_ASSERT(!SyncCache(path, other).Find(0xabc, 0xdef, cached));
+    other = settings;
+    other.MaxRefineShift = 5;
+    CPPUNIT_ASSERT(!SyncCache(path, other).Find(0xabc, 0xdef, cached));
+    other = settings;
+    other.MinConfidence = 0.8;
+    CPPUNIT_ASSERT(!SyncCache(path, other).Find(0xabc, 0xdef, cached));
+    std::remove(path.c_str());
+    std::remove((path + ".lock").c_str());
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper Functions
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<double> Pulse(double centre)
+{
+    // The brightness of a card briefly passing in front of the camera.
+    std::vector<double> brightness(120);
+    for(size_t i = 0; i < brightness.size(); i++)
+        brightness[i] = 80.0 + 60.0 * std::exp(-std::pow((i - centre) / 6.0, 2));
+    return brightness;
+}
@@ -0,0 +1,137 @@
+#include "test_thumbnails.h"
+#include "JsonBuilder.h"
+
+#include <opencv2/core/utils/filesystem.hpp>
+
+void ThumbnailTest::TestStrideDoubling()
+{
+    ThumbnailBuilder::Settings settings;
+    settings.Keyframes = 4;
+    ThumbnailBuilder builder(settings);
+
+    cv::Mat frames[2] = { cv::Mat(48, 64, CV_8UC3, cv::Scalar(40, 80, 120)), cv::Mat(48, 64, CV_8UC3, cv::Scalar(0)) };
+    std::vector<cv::Rect> boxes[2];
+
+    builder.Start(100);
+    CPPUNIT_ASSERT(builder.IsOpen());
+    for(int frame = 100; frame <= 130; frame++)
+        builder.Add(frame, frames, boxes);
+
+    // Samples stay evenly spaced from the first frame however long the event.
+    EventThumbnails thumbnails = builder.Finish();
+    CPPUNIT_ASSERT(!builder.IsOpen());
+    CPPUNIT_ASSERT(!thumbnails.strip.empty());
+    CPPUNIT_ASSERT_EQUAL((size_t)4, thumbnails.strip_frames.size());
+    CPPUNIT_ASSERT_EQUAL(100, thumbnails.strip_frames.front());
+    for(size_t i = 1; i < thumbnails.strip_frames.size(); i++)
+        CPPUNIT_ASSERT(thumbnails.strip_frames[i] > thumbnails.strip_frames[i - 1]);
+
+    // Both cameras are shrunk to the strip height and placed side by side.
+    cv::Mat strip = cv::imdecode(thumbnails.strip, cv::IMREAD_COLOR);
+    CPPUNIT_ASSERT_EQUAL(settings.Height, strip.rows);
+    CPPUNIT_ASSERT_EQUAL(4 * 2 * 128, strip.cols);
+
+    // Without objects there is no close up.
+    CPPUNIT_ASSERT(thumbnails.keyframe.empty());
+    CPPUNIT_ASSERT_EQUAL(-1, thumbnails.keyframe_frame);
+}
+
+void ThumbnailTest::TestLargestObject()
+{
+    ThumbnailBuilder::Settings settings;
+    ThumbnailBuilder builder(settings);
+    cv::Mat frames[2] = { cv::Mat(480, 640, CV_8UC3, cv::Scalar(0)), cv::Mat(480, 640, CV_8UC3, cv::Scalar(0)) };
+    std::vector<cv::Rect> boxes[2];
+
+    builder.Start(0);
+    boxes[0] = { cv::Rect(10, 10, 20, 20) };
+    builder.Add(0, frames, boxes);
+    boxes[0].clear();
+    boxes[1] = { cv::Rect(100, 100, 80, 40), cv::Rect(0, 0, 5, 5) };
+    builder.Add(1, frames, boxes);
+    boxes[1] = { cv::Rect(200, 200, 30, 30) };
+    builder.Add(2, frames, boxes);
+
+    EventThumbnails thumbnails = builder.Finish();
+    CPPUNIT_ASSERT(!thumbnails.keyframe.empty());
+    CPPUNIT_ASSERT_EQUAL(1, thumbnails.keyframe_frame);
+    CPPUNIT_ASSERT_EQUAL(1, thumbnails.keyframe_camera);
+    CPPUNIT_ASSERT(thumbnails.box == cv::Rect(100, 100, 80, 40));
+
+    // The close up is the box grown by a quarter on every side.
+    cv::Mat keyframe = cv::imdecode(thumbnails.keyframe, cv::IMREAD_COLOR);
+    CPPUNIT_ASSERT_EQUAL(120, keyframe.cols);
+    CPPUNIT_ASSERT_EQUAL(60, keyframe.rows);
+}
+
+void ThumbnailTest::TestClosed()
+{
+    ThumbnailBuilder::Settings settings;
+    ThumbnailBuilder builder(settings);
+    cv::Mat frames[2] = { cv::Mat(48, 64, CV_8UC3, cv::Scalar(0)), cv::Mat(48, 64, CV_8UC3, cv::Scalar(0)) };
+    std::vector<cv::Rect> boxes[2];
+
+    // Frames outside of an event are ignored.
+    builder.Add(0, frames, boxes);
+    EventThumbnails thumbnails = builder.Finish();
+    CPPUNIT_ASSERT(thumbnails.strip.empty());
+    CPPUNIT_ASSERT(thumbnails.strip_frames.empty());
+    CPPUNIT_ASSERT(thumbnails.keyframe.empty());
+}
+
+void ThumbnailTest::TestEventJSON()
+{
+    ActivityEvent event(1, 0, -1);
+    EventThumbnails thumbnails;
+    thumbnails.strip_frames = { 0, 4, 8 };
+    thumbnails.strip_file = "static/thumbnails/fish_1_strip.jpg";
+    thumbnails.keyframe_frame = 4;
+    thumbnails.keyframe_camera = 1;
+    thumbnails.box = cv::Rect(10, 20, 30, 40);
+    thumbnails.keyframe_file = "static/thumbnails/fish_1_keyframe.jpg";
+    event.SetThumbnails(thumbnails);
+
+    int end = 8;
+    event.EndEvent(end);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"Event_Activity_1\":{\"frame_end\":8,\"frame_start\":0,"
+                                     "\"thumbnails\":{\"keyframe\":\"static/thumbnails/fish_1_keyframe.jpg\","
+                                     "\"keyframe_box\":[4,1,10,20,30,40],"
+                                     "\"strip\":\"static/thumbnails/fish_1_strip.jpg\",\"strip_frames\":[0,4,8]}}}"),
+                         event.GetAsJSON().GetJSON());
+}
+
+void ThumbnailTest::TestWriteRename()
+{
+    std::string dir = "test_thumbnails";
+    cv::utils::fs::createDirectories(dir);
+
+    ThumbnailBuilder::Settings settings;
+    ThumbnailBuilder builder(settings);
+    cv::Mat frames[2] = { cv::Mat(48, 64, CV_8UC3, cv::Scalar(0)), cv::Mat(48, 64, CV_8UC3, cv::Scalar(0)) };
+    std::vector<cv::Rect> boxes[2] = { { cv::Rect(10, 10, 20, 20) }, {} };
+
+    // Every event is written as soon as it ends, named after its first frame.
+    EventThumbnails kept, dropped;
+    builder.Start(5);
+    builder.Add(5, frames, boxes);
+    kept = builder.Finish();
+    builder.Write(kept, cv::utils::fs::join(dir, "fish_start_5"));
+    builder.Start(40);
+    builder.Add(40, frames, boxes);
+    dropped = builder.Finish();
+    builder.Write(dropped, cv::utils::fs::join(dir, "fish_start_40"));
+    CPPUNIT_ASSERT(kept.strip.empty());
+    CPPUNIT_ASSERT(cv::utils::fs::exists(kept.strip_file));
+    CPPUNIT_ASSERT(cv::utils::fs::exists(dropped.keyframe_file));
+
+    // Once numbered, the kept event is renamed and the rest removed.
+    builder.Rename(kept, cv::utils::fs::join(dir, "fish_1"));
+    builder.RemoveUnused();
+    CPPUNIT_ASSERT_EQUAL(cv::utils::fs::join(dir, "fish_1_strip.jpg"), kept.strip_file);
+    CPPUNIT_ASSERT(cv::utils::fs::exists(kept.strip_file));
+    CPPUNIT_ASSERT(cv::utils::fs::exists(kept.keyframe_file));
+    CPPUNIT_ASSERT(!cv::utils::fs::exists(dropped.strip_file));
+    CPPUNIT_ASSERT(!cv::utils::fs::exists(dropped.keyframe_file));
+    cv::utils::fs::remove_all(dir);
+}
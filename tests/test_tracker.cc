@@ -1,5 +1,10 @@
 #include "test_tracker.h"
 
+#include <cstdio>
+#include <fstream>
+
+#include <opencv2/core/utils/filesystem.hpp>
+
 
 void TrackerTest::setUp()
 {
@@ -43,5 +48,278 @@ void TrackerTest::TestCheckForActivity()
 void TrackerTest::TestGetCascades()
 {
     _tracker->GetCascades();
+
+    // A missing cascade directory disables species detection.
+    _tracker->Config.CascadeDir = "does/not/exist/";
+    _tracker->GetCascades();
+
+    cv::Mat frame(120, 160, CV_8UC3, cv::Scalar(0, 0, 0));
+    _tracker->CreateMask(frame);
+    _tracker->DetectSpecies(frame);
+    CPPUNIT_ASSERT(_tracker->GetSpeciesCandidates().empty());
+}
+
+void TrackerTest::TestBackends()
+{
+    for(auto name : { "KNN", "MOG2", "GSOC", "LSBP", "CNT", "FRAME_DIFF", "RUNNING_AVG" })
+    {
+        Tracker::Settings config;
+        config.Subtractor = Tracker::GetBackend(name);
+        CPPUNIT_ASSERT_EQUAL(std::string(name), Tracker::GetBackendName(config.Subtractor));
+
+        // Every camera keeps its own background.
+        _tracker = std::make_unique<Tracker>(config);
+        cv::Mat frame(120, 160, CV_8UC3, cv::Scalar(0, 0, 0));
+        _tracker->CreateMask(frame, 0);
+        _tracker->CreateMask(frame, 1);
+    }
+
+    CPPUNIT_ASSERT_THROW(Tracker::GetBackend("NOPE"), std::runtime_error);
+}
+
+void TrackerTest::TestFrameDifference()
+{
+    FrameDifference diff(25);
+    cv::Mat frame(120, 160, CV_8UC3, cv::Scalar(0, 0, 0)), mask;
+
+    // Nothing moves on the first frame.
+    diff.apply(frame, mask);
+    CPPUNIT_ASSERT_EQUAL(0, cv::countNonZero(mask));
+
+    cv::rectangle(frame, cv::Rect(40, 30, 20, 10), cv::Scalar(255, 255, 255), cv::FILLED);
+    diff.apply(frame, mask);
+    CPPUNIT_ASSERT_EQUAL(200, cv::countNonZero(mask));
+
+    // Small changes fall under the threshold.
+    frame += cv::Scalar(10, 10, 10);
+    diff.apply(frame, mask);
+    CPPUNIT_ASSERT_EQUAL(0, cv::countNonZero(mask));
+}
+
+void TrackerTest::TestRunningAverage()
+{
+    // An odd width exercises the scalar tail after the vectorized pixels.
+    RunningAverage average(20, 5);
+    cv::Mat frame(120, 157, CV_8UC1, cv::Scalar(0)), mask;
+
+    CPPUNIT_ASSERT_EQUAL(0, average.Apply(frame, mask));
+    CPPUNIT_ASSERT_EQUAL(0, average.Apply(frame, mask));
+
+    cv::rectangle(frame, cv::Rect(140, 30, 17, 10), cv::Scalar(255), cv::FILLED);
+    CPPUNIT_ASSERT_EQUAL(170, average.Apply(frame, mask));
+    CPPUNIT_ASSERT_EQUAL(170, cv::countNonZero(mask));
+
+    // A change which stays put is learned into the background.
+    int changed = 0;
+    for(int i = 0; i < 200; i++)
+        changed = average.Apply(frame, mask);
+    CPPUNIT_ASSERT_EQUAL(0, changed);
+
+    cv::Mat background;
+    average.getBackgroundImage(background);
+    CPPUNIT_ASSERT(cv::norm(background, frame, cv::NORM_INF) <= 1);
+}
+
+void TrackerTest::TestHasActivity()
+{
+    _tracker->Config.GateTileSize = 16;
+    _tracker->Config.MinTileArea = 20;
+
+    cv::Mat mask(100, 90, CV_8UC1, cv::Scalar(0));
+    CPPUNIT_ASSERT(!_tracker->HasActivity(mask));
+    CPPUNIT_ASSERT(!_tracker->HasActivity(cv::Mat()));
+
+    // 25 pixels split over four tiles stay under the minimum in each.
+    cv::rectangle(mask, cv::Rect(14, 14, 5, 5), cv::Scalar(255), cv::FILLED);
+    CPPUNIT_ASSERT(!_tracker->HasActivity(mask));
+
+    // The partial tiles along the edges are checked too.
+    cv::rectangle(mask, cv::Rect(80, 96, 10, 4), cv::Scalar(255), cv::FILLED);
+    CPPUNIT_ASSERT(_tracker->HasActivity(mask));
+}
+
+void TrackerTest::TestDnnDetector()
+{
+    // The learned detector is off unless asked for.
+    CPPUNIT_ASSERT(_tracker->GetDetector() == nullptr);
+
+    Tracker::Settings config;
+    config.bUseDnn = true;
+    config.Dnn.Model = "missing_detector.onnx";
+    CPPUNIT_ASSERT_THROW(Tracker tracker(config), std::exception);
+
+    // A network which loads, but does not end in a DetectionOutput layer, is
+    // refused at its first batch.
+    std::string path = "test_flat_detector.prototxt";
+    {
+        std::ofstream file(path);
+        file << "name: \"flat\"\n"
+                "input: \"data\"\n"
+                "input_shape { dim: 1 dim: 3 dim: 300 dim: 300 }\n"
+                "layer { name: \"pool\" type: \"Pooling\" bottom: \"data\" top: \"pool\" "
+                "pooling_param { pool: MAX kernel_size: 30 stride: 30 } }\n"
+                "layer { name: \"flat\" type: \"Flatten\" bottom: \"pool\" top: \"flat\" }\n";
+    }
+    DnnDetector::Settings settings;
+    settings.Model = path;
+    settings.BatchSize = 1;
+    DnnDetector detector(settings);
+    cv::Mat frame(120, 160, CV_8UC3, cv::Scalar(0, 0, 0));
+    CPPUNIT_ASSERT_THROW(detector.Add(frame, cv::Rect(40, 30, 40, 30), 0), std::runtime_error);
+    std::remove(path.c_str());
 }
 
+void TrackerTest::TestFilterEvents()
+{
+    auto make_events = []() {
+        std::vector<ActivityEvent> events;
+        for(auto range : { std::make_pair(10, 12), std::make_pair(14, 40), std::make_pair(60, 61),
+                           std::make_pair(90, 90), std::make_pair(100, 130) })
+            events.emplace_back(int(events.size() + 1), range.first, range.second);
+        return events;
+    };
+
+    // By default only the events without any length are dropped.
+    Tracker::Settings settings;
+    auto events = make_events();
+    Tracker::FilterEvents(events, settings);
+    CPPUNIT_ASSERT_EQUAL((size_t)4, events.size());
+    CPPUNIT_ASSERT_EQUAL(100, events[3].GetRange().first);
+    CPPUNIT_ASSERT_EQUAL(4, events[3].GetId());
+
+    // The first two events are 2 frames apart, and merge into one long event
+    // before short events are dropped.
+    settings.MergeGap = 5;
+    settings.MinEventFrames = 5;
+    events = make_events();
+    Tracker::FilterEvents(events, settings);
+    CPPUNIT_ASSERT_EQUAL((size_t)2, events.size());
+    CPPUNIT_ASSERT_EQUAL(10, events[0].GetRange().first);
+    CPPUNIT_ASSERT_EQUAL(40, events[0].GetRange().second);
+    CPPUNIT_ASSERT_EQUAL(100, events[1].GetRange().first);
+
+    // Events are numbered again from 1, as the events JSON is read that way.
+    CPPUNIT_ASSERT_EQUAL(1, events[0].GetId());
+    CPPUNIT_ASSERT_EQUAL(2, events[1].GetId());
+}
+
+void TrackerTest::TestSkippedFrames()
+{
+    Tracker::Settings config;
+    config.Subtractor = Tracker::Backend::RUNNING_AVG;
+    config.CascadeDir = "does/not/exist/";
+    config.EnterFrames = 2;
+    _tracker = std::make_unique<Tracker>(config);
+
+    // Only every third frame is tracked while idle, and a fish shows up on
+    // frame 4, so the event is only opened by the second tracked frame with
+    // it, 9, and has to be backdated past the first, 6.
+    const int stride = 3;
+    for(int frame_num = 0; frame_num < 10; frame_num++)
+    {
+        cv::Mat frames[2];
+        for(int i = 0; i < 2; i++)
+        {
+            frames[i] = cv::Mat(120, 160, CV_8UC3, cv::Scalar(0, 0, 0));
+            if(frame_num >= 4)
+                cv::circle(frames[i], cv::Point(80, 60), 25, cv::Scalar(255, 255, 255), cv::FILLED);
+        }
+
+        if(_tracker->IsActive() || frame_num % stride == 0)
+        {
+            for(int i = 0; i < 2; i++)
+                _tracker->CreateMask(frames[i], i);
+            _tracker->CheckForActivity(frame_num);
+            CPPUNIT_ASSERT_EQUAL(frame_num == 6 ? (size_t)2 : (size_t)0, _tracker->GetSkippedCount());
+        }
+        else _tracker->SkipFrame(Tracker::SkippedFrame{ frame_num, { std::make_shared<cv::Mat>(frames[0]),
+                                                                     std::make_shared<cv::Mat>(frames[1]) } });
+    }
+
+    CPPUNIT_ASSERT(_tracker->IsActive());
+    CPPUNIT_ASSERT_EQUAL((size_t)1, _tracker->ActivityRange.size());
+    CPPUNIT_ASSERT_EQUAL(4, _tracker->ActivityRange[0].GetRange().first);
+}
+
+void TrackerTest::TestProbeFrame()
+{
+    Tracker::Settings config;
+    config.Subtractor = Tracker::Backend::RUNNING_AVG;
+    config.CascadeDir = "does/not/exist/";
+    _tracker = std::make_unique<Tracker>(config);
+
+    cv::Mat empty(120, 160, CV_8UC3, cv::Scalar(0, 0, 0)), fish = empty.clone();
+    cv::circle(fish, cv::Point(80, 60), 25, cv::Scalar(255, 255, 255), cv::FILLED);
+    _tracker->CreateMask(empty);
+    _tracker->CreateMask(fish);
+    auto boxes = _tracker->GetBoundingBoxes(0);
+    CPPUNIT_ASSERT(!boxes.empty());
+
+    // Probing finds objects without replacing those of the tracked frame.
+    cv::Mat probe = empty.clone();
+    CPPUNIT_ASSERT(!_tracker->ProbeFrame(probe));
+    CPPUNIT_ASSERT_EQUAL(boxes.size(), _tracker->GetBoundingBoxes(0).size());
+    CPPUNIT_ASSERT(boxes[0] == _tracker->GetBoundingBoxes(0)[0]);
+
+    probe = fish.clone();
+    CPPUNIT_ASSERT(_tracker->ProbeFrame(probe));
+}
+
+void TrackerTest::TestQuietSpecies()
+{
+    // A single stage cascade which accepts every window, so each object of a
+    // frame is a hit.
+    std::string dir = "test_cascades";
+    cv::utils::fs::createDirectories(dir);
+    {
+        std::ofstream file(cv::utils::fs::join(dir, "always.xml"));
+        file << "<?xml version=\"1.0\"?>\n<opencv_storage>\n<cascade>\n"
+                "<stageType>BOOST</stageType><featureType>HAAR</featureType>\n"
+                "<height>24</height><width>24</width>\n"
+                "<stageParams><maxWeakCount>1</maxWeakCount></stageParams>\n"
+                "<featureParams><maxCatCount>0</maxCatCount></featureParams>\n"
+                "<stageNum>1</stageNum>\n"
+                "<stages><_><maxWeakCount>1</maxWeakCount><stageThreshold>-1.</stageThreshold>\n"
+                "<weakClassifiers><_><internalNodes>0 -1 0 0.</internalNodes>"
+                "<leafValues>1. 1.</leafValues></_></weakClassifiers></_></stages>\n"
+                "<features><_><rects><_>0 0 24 24 -1.</_><_>0 0 12 24 2.</_></rects></_></features>\n"
+                "</cascade>\n</opencv_storage>\n";
+    }
+
+    Tracker::Settings config;
+    config.Subtractor = Tracker::Backend::RUNNING_AVG;
+    config.CascadeDir = dir;
+    config.ExitFrames = 10;
+    _tracker = std::make_unique<Tracker>(config);
+
+    auto species = [this]() {
+        std::string json = _tracker->ActivityRange.back().GetAsJSON().GetJSON();
+        size_t start = json.find("\"species\":");
+        return start == std::string::npos ? std::string() : json.substr(start, json.find('}', start) - start);
+    };
+
+    // The background stays empty, so the fish opens an event with a hit.
+    cv::Mat empty(120, 160, CV_8UC3, cv::Scalar(0, 0, 0)), fish = empty.clone();
+    cv::circle(fish, cv::Point(80, 60), 25, cv::Scalar(255, 255, 255), cv::FILLED);
+    int frame_num = 0;
+    _tracker->CreateMask(empty);
+    _tracker->CheckForActivity(frame_num);
+    frame_num++;
+    _tracker->CreateMask(fish, 0, 0);
+    _tracker->CheckForActivity(frame_num);
+    CPPUNIT_ASSERT(_tracker->IsActive());
+    std::string counted = species();
+    CPPUNIT_ASSERT(!counted.empty());
+
+    // Frames with too few changed pixels keep the event open without hits.
+    for(frame_num = 2; frame_num < 5; frame_num++)
+    {
+        _tracker->CreateMask(empty, 0, 0);
+        _tracker->CheckForActivity(frame_num);
+        CPPUNIT_ASSERT(_tracker->GetSpeciesCandidates().empty());
+    }
+    CPPUNIT_ASSERT(_tracker->IsActive());
+    CPPUNIT_ASSERT_EQUAL(counted, species());
+
+    cv::utils::fs::remove_all(dir);
+}